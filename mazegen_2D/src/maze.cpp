@@ -23,9 +23,13 @@
 
 #include "maze.hpp"
 
+#include <chrono>
+#include <cstdint>
+#include <random>
 #include <string>
 #include <stdexcept>
 
+#include <glibmm/main.h>
 #include <gtkmm/button.h>
 #include <gtkmm/filechooserdialog.h>
 #include <gtkmm/grid.h>
@@ -33,11 +37,20 @@
 #include <gtkmm/messagedialog.h>
 #include <gtkmm/separator.h>
 
+#include "mazegen/bulk_gen.hpp"
+#include "mazegen/maze_file.hpp"
 #include "util/logger.hpp"
 
+extern thread_local std::mt19937 prng; // defined in main.cpp
+
+// generation runs for up to gen_slice_ms out of every gen_frame_ms, redrawing
+// after each slice
+const unsigned int gen_frame_ms = 16;
+const unsigned int gen_slice_ms = 8;
+
 Maze::Maze(const unsigned int width, const unsigned int height):
-    _grid_width(Gtk::Adjustment::create(32, 1.0, 100.0, 1.0)),
-    _grid_height(Gtk::Adjustment::create(32, 1.0, 100.0, 1.0)),
+    _grid_width(Gtk::Adjustment::create(32, 1.0, 4096.0, 1.0)),
+    _grid_height(Gtk::Adjustment::create(32, 1.0, 4096.0, 1.0)),
     _room_attempts(Gtk::Adjustment::create(25, 0.0, 10000.0, 1.0)),
     _wall_rm_attempts(Gtk::Adjustment::create(100, 0.0, 10000.0, 1.0))
 {
@@ -50,7 +63,7 @@ Maze::Maze(const unsigned int width, const unsigned int height):
     layout->set_column_spacing(5);
     add(*layout);
 
-    layout->attach(_draw_area, 0, 0, 1, 10);
+    layout->attach(_draw_area, 0, 0, 1, 12);
     _draw_area.set_hexpand();
     _draw_area.set_vexpand();
     _draw_area.signal_draw().connect(sigc::bind<const unsigned int, const unsigned int>(sigc::mem_fun(*this, &Maze::draw), 0, 0));
@@ -70,8 +83,12 @@ Maze::Maze(const unsigned int width, const unsigned int height):
     _mazegen.append("Depth First Search");
     _mazegen.append("Prim's Algorithm");
     _mazegen.append("Kruskal's Algorithm");
+    _mazegen.append("Growing Tree");
+    _mazegen.append("Recursive Division");
+    _mazegen.append("Binary Tree");
+    _mazegen.append("Sidewinder");
     _mazegen.set_active_text("Depth First Search");
-    _mazegen.signal_changed().connect(sigc::mem_fun(*this, &Maze::regen));
+    _mazegen_changed = _mazegen.signal_changed().connect(sigc::mem_fun(*this, &Maze::regen));
 
     layout->attach(*Gtk::manage(new Gtk::Label("Room attempts")), 1, 4, 1, 1);
     layout->attach(_room_attempts, 2, 4, 1, 1);
@@ -83,18 +100,25 @@ Maze::Maze(const unsigned int width, const unsigned int height):
 
     layout->attach(*Gtk::manage(new Gtk::Separator(Gtk::ORIENTATION_HORIZONTAL)), 1, 6, 2, 1);
 
+    // the same seed & settings always give the same maze
+    layout->attach(*Gtk::manage(new Gtk::Label("Seed")), 1, 7, 1, 1);
+    layout->attach(_seed, 2, 7, 1, 1);
+    _seed.signal_activate().connect(sigc::mem_fun(*this, &Maze::regen));
+
+    layout->attach(*Gtk::manage(new Gtk::Separator(Gtk::ORIENTATION_HORIZONTAL)), 1, 8, 2, 1);
+
     Gtk::Button * regen_butt = Gtk::manage(new Gtk::Button("Regenerate"));
-    layout->attach(*regen_butt, 1, 7, 2, 1);
+    layout->attach(*regen_butt, 1, 9, 2, 1);
     regen_butt->set_hexpand(false);
     regen_butt->set_halign(Gtk::ALIGN_CENTER);
-    regen_butt->signal_clicked().connect(sigc::mem_fun(*this, &Maze::regen));
+    regen_butt->signal_clicked().connect(sigc::mem_fun(*this, &Maze::new_seed));
 
     Gtk::Label * spacer = Gtk::manage(new Gtk::Label);
     spacer->set_vexpand(true);
-    layout->attach(*spacer, 1, 8, 2, 1);
+    layout->attach(*spacer, 1, 10, 2, 1);
 
     Gtk::Grid * button_box = Gtk::manage(new Gtk::Grid);
-    layout->attach(*button_box, 1, 9, 2, 1);
+    layout->attach(*button_box, 1, 11, 2, 1);
     button_box->set_column_spacing(3);
     button_box->set_hexpand(false);
 
@@ -102,20 +126,32 @@ Maze::Maze(const unsigned int width, const unsigned int height):
     button_spacer->set_hexpand(true);
     button_box->attach(*button_spacer, 0, 0, 1, 1);
 
-    Gtk::Button * save_butt = Gtk::manage(new Gtk::Button("Save"));
-    button_box->attach(*save_butt, 1, 0, 1, 1);
+    Gtk::Button * open_maze_butt = Gtk::manage(new Gtk::Button("Open Maze"));
+    button_box->attach(*open_maze_butt, 1, 0, 1, 1);
+    open_maze_butt->set_hexpand(false);
+    open_maze_butt->set_halign(Gtk::ALIGN_CENTER);
+    open_maze_butt->signal_clicked().connect(sigc::mem_fun(*this, &Maze::open_maze));
+
+    Gtk::Button * save_maze_butt = Gtk::manage(new Gtk::Button("Save Maze"));
+    button_box->attach(*save_maze_butt, 2, 0, 1, 1);
+    save_maze_butt->set_hexpand(false);
+    save_maze_butt->set_halign(Gtk::ALIGN_CENTER);
+    save_maze_butt->signal_clicked().connect(sigc::mem_fun(*this, &Maze::save_maze));
+
+    Gtk::Button * save_butt = Gtk::manage(new Gtk::Button("Save Image"));
+    button_box->attach(*save_butt, 3, 0, 1, 1);
     save_butt->set_hexpand(false);
     save_butt->set_halign(Gtk::ALIGN_CENTER);
     save_butt->signal_clicked().connect(sigc::mem_fun(*this, &Maze::save));
 
     Gtk::Button * close_butt = Gtk::manage(new Gtk::Button("Close"));
-    button_box->attach(*close_butt, 2, 0, 1, 1);
+    button_box->attach(*close_butt, 4, 0, 1, 1);
     close_butt->set_hexpand(false);
     close_butt->set_halign(Gtk::ALIGN_CENTER);
     close_butt->signal_clicked().connect(sigc::mem_fun(*this, &Maze::hide));
 
     show_all_children();
-    regen();
+    new_seed();
 }
 
 bool Maze::draw(const Cairo::RefPtr<Cairo::Context> & cr, const unsigned int width, const unsigned int height)
@@ -143,26 +179,47 @@ bool Maze::draw(const Cairo::RefPtr<Cairo::Context> & cr, const unsigned int wid
 
     cr->stroke();
 
-    double cell_scale_x = width_d / (double)_grid->grid[0].size();
-    double cell_scale_y = height_d / (double)_grid->grid.size();
+    double cell_scale_x = width_d / (double)_grid->width();
+    double cell_scale_y = height_d / (double)_grid->height();
 
-    // draw maze cells
-    for(std::size_t row = 0; row < _grid->grid.size(); ++row)
+    // draw maze walls. Each straight run of walls is one line, so large grids
+    // don't need a path segment per cell
+    for(unsigned int row = 0; row < _grid->height(); ++row)
     {
-        for(std::size_t col = 0; col < _grid->grid[row].size(); ++col)
+        for(unsigned int col = 0; col < _grid->width();)
         {
-            sf::Vector2f ul(cell_scale_x * (double)col, cell_scale_y * (double)row);
-
-            if(_grid->grid[row][col].walls[UP])
+            if(!_grid->wall(col, row, UP))
             {
-                cr->move_to(ul.x, ul.y);
-                cr->line_to(ul.x + cell_scale_x, ul.y);
+                ++col;
+                continue;
             }
-            if(_grid->grid[row][col].walls[LEFT])
+
+            unsigned int end = col + 1;
+            while(end < _grid->width() && _grid->wall(end, row, UP))
+                ++end;
+
+            cr->move_to(cell_scale_x * (double)col, cell_scale_y * (double)row);
+            cr->line_to(cell_scale_x * (double)end, cell_scale_y * (double)row);
+            col = end;
+        }
+    }
+    for(unsigned int col = 0; col < _grid->width(); ++col)
+    {
+        for(unsigned int row = 0; row < _grid->height();)
+        {
+            if(!_grid->wall(col, row, LEFT))
             {
-                cr->move_to(ul.x, ul.y);
-                cr->line_to(ul.x, ul.y + cell_scale_y);
+                ++row;
+                continue;
             }
+
+            unsigned int end = row + 1;
+            while(end < _grid->height() && _grid->wall(col, end, LEFT))
+                ++end;
+
+            cr->move_to(cell_scale_x * (double)col, cell_scale_y * (double)row);
+            cr->line_to(cell_scale_x * (double)col, cell_scale_y * (double)end);
+            row = end;
         }
     }
 
@@ -181,25 +238,104 @@ void Maze::regen()
 
     Grid::Mazegen_alg mazegen;
     std::string mazegen_txt = _mazegen.get_active_text();
-    if(mazegen_txt == "Depth First Search")
+    bool bulk = mazegen_txt == "Binary Tree" || mazegen_txt == "Sidewinder";
+    if(bulk)
+        mazegen = Grid::MAZEGEN_DFS; // unused
+    else if(mazegen_txt == "Depth First Search")
         mazegen = Grid::MAZEGEN_DFS;
     else if(mazegen_txt == "Prim's Algorithm")
         mazegen = Grid::MAZEGEN_PRIM;
     else if(mazegen_txt == "Kruskal's Algorithm")
         mazegen = Grid::MAZEGEN_KRUSKAL;
+    else if(mazegen_txt == "Growing Tree")
+        mazegen = Grid::MAZEGEN_GROWING_TREE;
+    else if(mazegen_txt == "Recursive Division")
+        mazegen = Grid::MAZEGEN_DIVISION;
     else
     {
         Logger_locator::get()(Logger::ERROR, std::string("Unknown maze algorithm: ") + mazegen_txt);
         throw std::invalid_argument(std::string("Unknown maze algorithm: ") + mazegen_txt);
     }
 
-    _grid.reset(new Grid(grid_width, grid_height, mazegen, room_attempts, wall_rm_attempts));
+    std::uint64_t seed;
+    try
+    {
+        seed = std::stoull(_seed.get_text());
+    }
+    catch(const std::logic_error &)
+    {
+        Logger_locator::get()(Logger::WARN, std::string("Invalid seed: ") + _seed.get_text() + ". Picking a new one");
+        new_seed();
+        return;
+    }
+
+    stop_gen();
 
+    // the bulk generators fill the whole grid, so there are no rooms
+    if(bulk)
+    {
+        _grid.reset(new Grid(grid_width, grid_height, seed));
+        if(mazegen_txt == "Binary Tree")
+            Binary_tree_gen::fill(*_grid);
+        else
+            Sidewinder_gen::fill(*_grid);
+        _grid->destroy_rand_walls(wall_rm_attempts);
+        _grid_mazegen = mazegen_txt == "Binary Tree" ? Maze_file_header::mazegen_binary_tree :
+            Maze_file_header::mazegen_sidewinder;
+    }
+    else
+    {
+        _grid.reset(new Grid(grid_width, grid_height, seed));
+        _builder.reset(new Maze_builder(*_grid, mazegen, room_attempts, wall_rm_attempts));
+        _grid_mazegen = mazegen;
+        _gen_connection = Glib::signal_timeout().connect(sigc::mem_fun(*this, &Maze::gen_step), gen_frame_ms);
+    }
+
+    _grid_room_attempts = room_attempts;
+    _grid_wall_rm_attempts = wall_rm_attempts;
+
+    _draw_area.queue_draw();
+}
+
+bool Maze::gen_step()
+{
+    bool done = _builder->step_for(std::chrono::milliseconds(gen_slice_ms));
+    if(done)
+    {
+        _builder.reset();
+        Logger_locator::get()(Logger::DBG, "Maze generated");
+    }
+
+    _draw_area.queue_draw();
+    return !done;
+}
+
+void Maze::stop_gen()
+{
+    _gen_connection.disconnect();
+    _builder.reset();
+}
+
+void Maze::finish_gen()
+{
+    if(!_builder)
+        return;
+
+    _builder->finish();
+    stop_gen();
     _draw_area.queue_draw();
 }
 
+void Maze::new_seed()
+{
+    _seed.set_text(std::to_string(std::uniform_int_distribution<std::uint64_t>()(prng)));
+    regen();
+}
+
 void Maze::save()
 {
+    finish_gen();
+
     // get image size from user
     Gtk::Dialog size_dialog("Image Size", *this, true);
     size_dialog.add_button("OK", Gtk::RESPONSE_OK);
@@ -277,3 +413,124 @@ void Maze::save()
         error_box.run();
     }
 }
+
+void Maze::save_maze()
+{
+    finish_gen();
+
+    Gtk::FileChooserDialog chooser(*this, "Save maze to", Gtk::FILE_CHOOSER_ACTION_SAVE);
+    chooser.set_modal(true);
+    chooser.set_current_folder(".");
+    chooser.set_select_multiple(false);
+    chooser.set_do_overwrite_confirmation(true);
+    chooser.add_button("Cancel", Gtk::RESPONSE_CANCEL);
+    chooser.add_button("Save", Gtk::RESPONSE_OK);
+
+    Glib::RefPtr<Gtk::FileFilter> maze_type = Gtk::FileFilter::create();
+    maze_type->set_name("Maze files");
+    maze_type->add_pattern("*.mzg");
+    chooser.add_filter(maze_type);
+
+    if(chooser.run() != Gtk::RESPONSE_OK)
+        return;
+
+    chooser.hide();
+
+    try
+    {
+        write_maze_file(chooser.get_filename(), *_grid, _grid_mazegen, _grid_room_attempts, _grid_wall_rm_attempts);
+        Logger_locator::get()(Logger::DBG, "Saved maze to " + chooser.get_filename());
+    }
+    catch(const std::exception & e)
+    {
+        Logger_locator::get()(Logger::WARN, std::string("Error saving maze to ") + chooser.get_filename());
+        Gtk::MessageDialog error_box(*this, std::string("Error saving maze to ") + chooser.get_filename(),
+            false, Gtk::MESSAGE_ERROR, Gtk::BUTTONS_OK, true);
+        error_box.set_secondary_text(e.what());
+        error_box.run();
+    }
+}
+
+void Maze::open_maze()
+{
+    Gtk::FileChooserDialog chooser(*this, "Open maze", Gtk::FILE_CHOOSER_ACTION_OPEN);
+    chooser.set_modal(true);
+    chooser.set_current_folder(".");
+    chooser.set_select_multiple(false);
+    chooser.add_button("Cancel", Gtk::RESPONSE_CANCEL);
+    chooser.add_button("Open", Gtk::RESPONSE_OK);
+
+    Glib::RefPtr<Gtk::FileFilter> maze_type = Gtk::FileFilter::create();
+    maze_type->set_name("Maze files");
+    maze_type->add_pattern("*.mzg");
+    chooser.add_filter(maze_type);
+
+    if(chooser.run() != Gtk::RESPONSE_OK)
+        return;
+
+    chooser.hide();
+
+    try
+    {
+        Maze_file file(chooser.get_filename());
+        stop_gen();
+        _grid = file.to_grid();
+        _grid_mazegen = file.mazegen();
+        _grid_room_attempts = file.room_attempts();
+        _grid_wall_rm_attempts = file.wall_rm_attempts();
+
+        // show the loaded maze's settings. These don't emit activate, so they won't regen.
+        // Settings the file doesn't know are left as they are
+        _grid_width.set_value(file.width());
+        _grid_height.set_value(file.height());
+        _seed.set_text(std::to_string(file.seed()));
+        if(file.room_attempts() != Maze_file_header::attempts_unknown)
+            _room_attempts.set_value(file.room_attempts());
+        if(file.wall_rm_attempts() != Maze_file_header::attempts_unknown)
+            _wall_rm_attempts.set_value(file.wall_rm_attempts());
+
+        std::string mazegen_txt;
+        switch(file.mazegen())
+        {
+        case Grid::MAZEGEN_DFS:
+            mazegen_txt = "Depth First Search";
+            break;
+        case Grid::MAZEGEN_PRIM:
+            mazegen_txt = "Prim's Algorithm";
+            break;
+        case Grid::MAZEGEN_KRUSKAL:
+            mazegen_txt = "Kruskal's Algorithm";
+            break;
+        case Grid::MAZEGEN_GROWING_TREE:
+            mazegen_txt = "Growing Tree";
+            break;
+        case Grid::MAZEGEN_DIVISION:
+            mazegen_txt = "Recursive Division";
+            break;
+        case Maze_file_header::mazegen_binary_tree:
+            mazegen_txt = "Binary Tree";
+            break;
+        case Maze_file_header::mazegen_sidewinder:
+            mazegen_txt = "Sidewinder";
+            break;
+        }
+        if(!mazegen_txt.empty())
+        {
+            _mazegen_changed.block();
+            _mazegen.set_active_text(mazegen_txt);
+            _mazegen_changed.unblock();
+        }
+
+        Logger_locator::get()(Logger::DBG, "Opened maze " + chooser.get_filename());
+    }
+    catch(const std::exception & e)
+    {
+        Logger_locator::get()(Logger::WARN, std::string("Error opening maze ") + chooser.get_filename());
+        Gtk::MessageDialog error_box(*this, std::string("Error opening maze ") + chooser.get_filename(),
+            false, Gtk::MESSAGE_ERROR, Gtk::BUTTONS_OK, true);
+        error_box.set_secondary_text(e.what());
+        error_box.run();
+    }
+
+    _draw_area.queue_draw();
+}
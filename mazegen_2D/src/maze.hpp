@@ -24,14 +24,17 @@
 #ifndef MAZE_HPP
 #define MAZE_HPP
 
+#include <cstdint>
 #include <memory>
 
 #include <gtkmm/comboboxtext.h>
 #include <gtkmm/drawingarea.h>
+#include <gtkmm/entry.h>
 #include <gtkmm/spinbutton.h>
 #include <gtkmm/window.h>
 
 #include "mazegen/grid.hpp"
+#include "mazegen/maze_builder.hpp"
 
 class Maze final: public Gtk::Window
 {
@@ -40,9 +43,29 @@ public:
 private:
     bool draw(const Cairo::RefPtr<Cairo::Context> & cr, const unsigned int width, const unsigned int height);
     void regen();
+    // run a slice of generation. Returns false once the maze is finished,
+    // to stop being called
+    bool gen_step();
+    // stop generating, leaving the grid as it is, or finish generating now
+    void stop_gen();
+    void finish_gen();
+    // pick a new random seed, then regen
+    void new_seed();
     void save();
+    void save_maze();
+    void open_maze();
 
     std::unique_ptr<Grid> _grid;
+    // settings _grid was made with, as stored in maze files
+    std::uint32_t _grid_mazegen;
+    std::uint32_t _grid_room_attempts;
+    std::uint32_t _grid_wall_rm_attempts;
+    // generates _grid over several frames, so the window stays responsive.
+    // Null once the maze is finished
+    std::unique_ptr<Maze_builder> _builder;
+    sigc::connection _gen_connection;
+    // blocked while a loaded maze's algorithm is shown, so it isn't regenerated
+    sigc::connection _mazegen_changed;
 
     Gtk::DrawingArea _draw_area;
 
@@ -51,6 +74,7 @@ private:
     Gtk::ComboBoxText _mazegen;
     Gtk::SpinButton _room_attempts;
     Gtk::SpinButton _wall_rm_attempts;
+    Gtk::Entry _seed;
 };
 
 #endif // MAZE_HPP
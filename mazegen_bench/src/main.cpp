@@ -0,0 +1,550 @@
+// main.cpp
+// headless maze generation benchmark
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Runs each maze generation phase on its own over a range of square grid
+// sizes, and reports timing & memory as CSV or JSON on stdout. Pathfinding
+// phases time a batch of queries on a generated maze instead
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef __unix__
+    #include <sys/resource.h>
+#endif
+#ifdef __GLIBC__
+    #include <malloc.h>
+#endif
+
+#include "mazegen/bulk_gen.hpp"
+#include "mazegen/eller.hpp"
+#include "mazegen/flow_field.hpp"
+#include "mazegen/nav_graph.hpp"
+#include "mazegen/grid.hpp"
+#include "mazegen/pathfind.hpp"
+#include "mazegen/region_pathfind.hpp"
+#include "mazegen/rng.hpp"
+
+struct Phase
+{
+    std::string name;
+    // prepare a grid, then time the phase on it. returns elapsed seconds
+    std::function<double(const unsigned int size, const std::uint64_t seed)> run;
+    // times a batch of path queries rather than generating cells
+    bool queries = false;
+};
+
+struct Options
+{
+    unsigned int min_size = 32;
+    unsigned int max_size = 16384;
+    unsigned int reps = 3;
+    std::uint64_t seed = 1;
+    // room & wall removal attempts per 1024 cells (the game uses 25 & 100 on a 32x32 grid)
+    double room_density = 25.0;
+    double wall_rm_density = 100.0;
+    Grid::Layout layout = Grid::LAYOUT_ROW_MAJOR;
+    unsigned int tile_size = 256;
+    unsigned int num_threads = 0;
+    unsigned int path_queries = 1000;
+    unsigned int path_radius = 64;
+    unsigned int cluster_size = 32;
+    bool json = false;
+    std::vector<std::string> phases;
+};
+
+// start a new peak resident set size measurement. On Linux, this resets the
+// process's high-water mark to its current size, so each phase's peak isn't
+// hidden by an earlier, larger one. Memory freed by earlier phases is given
+// back first, so it isn't counted either. Elsewhere the peak covers the whole
+// run
+void reset_peak_rss()
+{
+    #ifdef __linux__
+        #ifdef __GLIBC__
+            malloc_trim(0);
+        #endif
+        std::ofstream clear_refs("/proc/self/clear_refs");
+        clear_refs<<"5"<<std::flush;
+    #endif
+}
+
+// peak resident set size since reset_peak_rss, in KiB, or -1 if unknown
+long peak_rss_kb()
+{
+    #ifdef __linux__
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while(std::getline(status, line))
+        {
+            if(line.compare(0, 6, "VmHWM:") == 0)
+                return std::strtol(line.c_str() + 6, nullptr, 10);
+        }
+        return -1;
+    #elif defined(__unix__)
+        rusage usage;
+        if(getrusage(RUSAGE_SELF, &usage) != 0)
+            return -1;
+        #ifdef __APPLE__
+            return usage.ru_maxrss / 1024;
+        #else
+            return usage.ru_maxrss;
+        #endif
+    #else
+        return -1;
+    #endif
+}
+
+double time_it(const std::function<void()> & f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::vector<Phase> get_phases(const Options & opts)
+{
+    auto room_attempts = [&opts](const unsigned int size)
+    {
+        return (unsigned int)((double)size * size * opts.room_density / 1024.0);
+    };
+    auto wall_rm_attempts = [&opts](const unsigned int size)
+    {
+        return (unsigned int)((double)size * size * opts.wall_rm_density / 1024.0);
+    };
+
+    auto mazegen_phase = [&opts](const Grid::Mazegen_alg mazegen)
+    {
+        return [&opts, mazegen](const unsigned int size, const std::uint64_t seed)
+        {
+            Grid grid(size, size, seed, opts.layout);
+            return time_it([&](){ grid.fill_mazes(mazegen, 0); });
+        };
+    };
+
+    auto tiled_phase = [&opts](const Grid::Mazegen_alg mazegen)
+    {
+        return [&opts, mazegen](const unsigned int size, const std::uint64_t seed)
+        {
+            Grid grid(size, size, seed, opts.layout);
+            return time_it([&]()
+            {
+                int num_regions = grid.fill_mazes_tiled(mazegen, 0, opts.tile_size, opts.num_threads);
+                grid.join_regions(num_regions);
+            });
+        };
+    };
+
+    // pick endpoints up front, so only the searches are timed
+    auto path_queries = [&opts](const unsigned int size, const std::uint64_t seed)
+    {
+        Mazegen_rng prng(substream_seed(seed, 1));
+        auto near = [&prng, size, &opts](const unsigned int center)
+        {
+            if(opts.path_radius == 0)
+                return (unsigned int)(prng() % size);
+            unsigned int lo = center > opts.path_radius ? center - opts.path_radius : 0;
+            unsigned int hi = std::min(size - 1, center + opts.path_radius);
+            return lo + (unsigned int)(prng() % (hi - lo + 1));
+        };
+
+        std::vector<std::pair<sf::Vector2u, sf::Vector2u>> queries(opts.path_queries);
+        for(auto & query: queries)
+        {
+            query.first = sf::Vector2u(prng() % size, prng() % size);
+            query.second = sf::Vector2u(near(query.first.x), near(query.first.y));
+        }
+        return queries;
+    };
+
+    auto path_phase = [&opts, room_attempts, wall_rm_attempts, path_queries](const Pathfinder::Method method)
+    {
+        return [&opts, room_attempts, wall_rm_attempts, path_queries, method](const unsigned int size, const std::uint64_t seed)
+        {
+            Grid grid(size, size, Grid::MAZEGEN_DFS, room_attempts(size), wall_rm_attempts(size), seed, opts.layout);
+            Pathfinder pathfinder(grid);
+            auto queries = path_queries(size, seed);
+
+            std::vector<sf::Vector2u> path;
+            return time_it([&]()
+            {
+                for(const auto & query: queries)
+                    pathfinder.find_path(query.first, query.second, path, method);
+            });
+        };
+    };
+
+    // the abstract graph is built before timing, as in the game it would be
+    // built once per maze
+    auto region_phase = [&opts, room_attempts, wall_rm_attempts, path_queries](const bool refine)
+    {
+        return [&opts, room_attempts, wall_rm_attempts, path_queries, refine](const unsigned int size, const std::uint64_t seed)
+        {
+            Grid grid(size, size, Grid::MAZEGEN_DFS, room_attempts(size), wall_rm_attempts(size), seed, opts.layout);
+            Region_pathfinder pathfinder(grid, opts.cluster_size, opts.num_threads);
+            auto queries = path_queries(size, seed);
+
+            std::vector<sf::Vector2u> path;
+            return time_it([&]()
+            {
+                for(const auto & query: queries)
+                {
+                    if(refine)
+                        pathfinder.find_path(query.first, query.second, path);
+                    else
+                        pathfinder.distance(query.first, query.second);
+                }
+            });
+        };
+    };
+
+    return
+    {
+        {"dfs", mazegen_phase(Grid::MAZEGEN_DFS)},
+        {"prim", mazegen_phase(Grid::MAZEGEN_PRIM)},
+        {"kruskal", mazegen_phase(Grid::MAZEGEN_KRUSKAL)},
+        {"growing_tree", mazegen_phase(Grid::MAZEGEN_GROWING_TREE)},
+        {"division", mazegen_phase(Grid::MAZEGEN_DIVISION)},
+        {"eller", [&opts](const unsigned int size, const std::uint64_t seed)
+        {
+            Grid grid(size, size, seed, opts.layout);
+            return time_it([&](){ Eller_gen::fill(grid); });
+        }},
+        {"eller_stream", [](const unsigned int size, const std::uint64_t seed)
+        {
+            Eller_gen gen(size, size, seed);
+            Maze_row row;
+            return time_it([&](){ while(gen.next_row(row)); });
+        }},
+        {"binary_tree", [&opts](const unsigned int size, const std::uint64_t seed)
+        {
+            Grid grid(size, size, seed, opts.layout);
+            return time_it([&](){ Binary_tree_gen::fill(grid); });
+        }},
+        {"sidewinder", [&opts](const unsigned int size, const std::uint64_t seed)
+        {
+            Grid grid(size, size, seed, opts.layout);
+            return time_it([&](){ Sidewinder_gen::fill(grid); });
+        }},
+        {"sidewinder_stream", [](const unsigned int size, const std::uint64_t seed)
+        {
+            Sidewinder_gen gen(size, size, seed);
+            Maze_row row;
+            return time_it([&](){ while(gen.next_row(row)); });
+        }},
+        {"dfs_tiled", tiled_phase(Grid::MAZEGEN_DFS)},
+        {"prim_tiled", tiled_phase(Grid::MAZEGEN_PRIM)},
+        {"kruskal_tiled", tiled_phase(Grid::MAZEGEN_KRUSKAL)},
+        {"gen_rooms", [&opts, room_attempts](const unsigned int size, const std::uint64_t seed)
+        {
+            Grid grid(size, size, seed, opts.layout);
+            return time_it([&](){ grid.place_rooms(room_attempts(size)); });
+        }},
+        {"join_regions", [&opts, room_attempts](const unsigned int size, const std::uint64_t seed)
+        {
+            Grid grid(size, size, seed, opts.layout);
+            int num_regions = grid.place_rooms(room_attempts(size));
+            num_regions = grid.fill_mazes(Grid::MAZEGEN_DFS, num_regions);
+            return time_it([&](){ grid.join_regions(num_regions); });
+        }},
+        {"destroy_rand_walls", [&opts, room_attempts, wall_rm_attempts](const unsigned int size, const std::uint64_t seed)
+        {
+            Grid grid(size, size, seed, opts.layout);
+            int num_regions = grid.place_rooms(room_attempts(size));
+            num_regions = grid.fill_mazes(Grid::MAZEGEN_DFS, num_regions);
+            grid.join_regions(num_regions);
+            return time_it([&](){ grid.destroy_rand_walls(wall_rm_attempts(size)); });
+        }},
+        {"astar", path_phase(Pathfinder::A_STAR), true},
+        {"jps", path_phase(Pathfinder::JUMP_POINT), true},
+        {"region_build", [&opts, room_attempts, wall_rm_attempts](const unsigned int size, const std::uint64_t seed)
+        {
+            Grid grid(size, size, Grid::MAZEGEN_DFS, room_attempts(size), wall_rm_attempts(size), seed, opts.layout);
+            return time_it([&](){ Region_pathfinder pathfinder(grid, opts.cluster_size, opts.num_threads); });
+        }},
+        {"nav_graph", [&opts, room_attempts, wall_rm_attempts](const unsigned int size, const std::uint64_t seed)
+        {
+            Grid grid(size, size, Grid::MAZEGEN_DFS, room_attempts(size), wall_rm_attempts(size), seed, opts.layout);
+            return time_it([&](){ Nav_graph graph(grid); });
+        }},
+        {"nav_bfs", [&opts, room_attempts, wall_rm_attempts](const unsigned int size, const std::uint64_t seed)
+        {
+            Grid grid(size, size, Grid::MAZEGEN_DFS, room_attempts(size), wall_rm_attempts(size), seed, opts.layout);
+            Nav_graph graph(grid);
+            std::vector<std::uint32_t> hops;
+            return time_it([&](){ graph.bfs(0, hops, opts.num_threads); });
+        }},
+        {"nav_dijkstra", [&opts, room_attempts, wall_rm_attempts](const unsigned int size, const std::uint64_t seed)
+        {
+            Grid grid(size, size, Grid::MAZEGEN_DFS, room_attempts(size), wall_rm_attempts(size), seed, opts.layout);
+            Nav_graph graph(grid);
+            std::vector<std::uint32_t> dist;
+            return time_it([&](){ graph.dijkstra(0, dist); });
+        }},
+        {"region_path", region_phase(true), true},
+        {"region_dist", region_phase(false), true},
+        {"flow_field", [&opts, room_attempts, wall_rm_attempts](const unsigned int size, const std::uint64_t seed)
+        {
+            Grid grid(size, size, Grid::MAZEGEN_DFS, room_attempts(size), wall_rm_attempts(size), seed, opts.layout);
+            std::vector<sf::Vector2u> targets = {sf::Vector2u(size / 2, size / 2)};
+            return time_it([&](){ Flow_field field(grid, targets, opts.num_threads); });
+        }},
+        {"flow_update", [&opts, room_attempts, wall_rm_attempts](const unsigned int size, const std::uint64_t seed)
+        {
+            Grid grid(size, size, Grid::MAZEGEN_DFS, room_attempts(size), wall_rm_attempts(size), seed, opts.layout);
+            Flow_field field(grid, {sf::Vector2u(size / 2, size / 2)}, opts.num_threads);
+
+            // knock out random interior walls, as destroy_rand_walls does
+            Mazegen_rng prng(substream_seed(seed, 1));
+            std::vector<std::pair<sf::Vector2u, Direction>> walls(opts.path_queries);
+            for(auto & wall: walls)
+            {
+                wall.second = prng() % 2 ? RIGHT : DOWN;
+                wall.first = sf::Vector2u(prng() % (wall.second == RIGHT ? size - 1 : size),
+                    prng() % (wall.second == DOWN ? size - 1 : size));
+            }
+
+            return time_it([&]()
+            {
+                for(const auto & wall: walls)
+                {
+                    grid.set_wall(wall.first.x, wall.first.y, wall.second, false);
+                    field.update_wall(grid, wall.first.x, wall.first.y, wall.second);
+                }
+            });
+        }, true}
+    };
+}
+
+void usage(const char * prog)
+{
+    std::cerr<<"usage: "<<prog<<" [options]\n"
+        <<"  --min N              smallest grid side (default 32)\n"
+        <<"  --max N              largest grid side (default 16384). sides double from min to max\n"
+        <<"  --reps N             repetitions per phase & size (default 3)\n"
+        <<"  --seed N             base seed; rep r uses seed N + r (default 1)\n"
+        <<"  --room-density D     room attempts per 1024 cells (default 25)\n"
+        <<"  --wall-rm-density D  wall removal attempts per 1024 cells (default 100)\n"
+        <<"  --layout row|z       grid storage layout (default row)\n"
+        <<"  --tile-size N        tile side for *_tiled phases, a multiple of 64 (default 256)\n"
+        <<"  --threads N          worker threads for *_tiled, flow, region_build & nav_bfs\n"
+        <<"                       phases (default 0: all cores)\n"
+        <<"  --queries N          path queries per rep for astar, jps & region_*, or wall\n"
+        <<"                       removals for flow_update (default 1000)\n"
+        <<"  --radius N           max distance on each axis from start to goal for\n"
+        <<"                       path queries (default 64, 0: anywhere)\n"
+        <<"  --cluster-size N     sector side for region_* phases (default 32)\n"
+        <<"  --phase NAME         run only this phase (may be repeated):\n"
+        <<"                       dfs prim kruskal growing_tree division eller eller_stream\n"
+        <<"                       binary_tree sidewinder sidewinder_stream\n"
+        <<"                       dfs_tiled prim_tiled kruskal_tiled\n"
+        <<"                       gen_rooms join_regions destroy_rand_walls\n"
+        <<"                       astar jps flow_field flow_update\n"
+        <<"                       region_build region_path region_dist\n"
+        <<"                       nav_graph nav_bfs nav_dijkstra\n"
+        <<"                       *_tiled phases include stitching tiles with join_regions\n"
+        <<"                       astar, jps & region_* time queries on a fully generated maze\n"
+        <<"                       region_dist skips filling in the cells of each path\n"
+        <<"                       nav_bfs & nav_dijkstra search the whole nav graph from one node\n"
+        <<"                       flow_field times a full search from the center cell\n"
+        <<"                       flow_update times incremental updates as walls are removed\n"
+        <<"  --format csv|json    output format (default csv)\n";
+}
+
+bool parse_args(int argc, char * argv[], Options & opts)
+{
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if(arg == "--help" || arg == "-h")
+            return false;
+
+        if(i + 1 >= argc)
+        {
+            std::cerr<<"Missing value for "<<arg<<std::endl;
+            return false;
+        }
+        std::string val = argv[++i];
+
+        try
+        {
+            if(arg == "--min")
+                opts.min_size = std::stoul(val);
+            else if(arg == "--max")
+                opts.max_size = std::stoul(val);
+            else if(arg == "--reps")
+                opts.reps = std::stoul(val);
+            else if(arg == "--seed")
+                opts.seed = std::stoull(val);
+            else if(arg == "--room-density")
+                opts.room_density = std::stod(val);
+            else if(arg == "--wall-rm-density")
+                opts.wall_rm_density = std::stod(val);
+            else if(arg == "--layout" && (val == "row" || val == "z"))
+                opts.layout = val == "z" ? Grid::LAYOUT_Z_ORDER : Grid::LAYOUT_ROW_MAJOR;
+            else if(arg == "--tile-size")
+                opts.tile_size = std::stoul(val);
+            else if(arg == "--threads")
+                opts.num_threads = std::stoul(val);
+            else if(arg == "--queries")
+                opts.path_queries = std::stoul(val);
+            else if(arg == "--radius")
+                opts.path_radius = std::stoul(val);
+            else if(arg == "--cluster-size")
+                opts.cluster_size = std::stoul(val);
+            else if(arg == "--phase")
+                opts.phases.push_back(val);
+            else if(arg == "--format" && (val == "csv" || val == "json"))
+                opts.json = val == "json";
+            else
+            {
+                std::cerr<<"Unknown option: "<<arg<<" "<<val<<std::endl;
+                return false;
+            }
+        }
+        catch(const std::logic_error &)
+        {
+            std::cerr<<"Invalid value for "<<arg<<": "<<val<<std::endl;
+            return false;
+        }
+    }
+
+    if(opts.min_size == 0 || opts.max_size < opts.min_size || opts.reps == 0)
+    {
+        std::cerr<<"Invalid size range or repetition count"<<std::endl;
+        return false;
+    }
+
+    if(opts.path_queries == 0)
+    {
+        std::cerr<<"Path query count must be positive"<<std::endl;
+        return false;
+    }
+
+    if(opts.tile_size == 0 || opts.tile_size % 64 != 0)
+    {
+        std::cerr<<"Tile size must be a multiple of 64"<<std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char * argv[])
+{
+    Options opts;
+    if(!parse_args(argc, argv, opts))
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<Phase> phases = get_phases(opts);
+
+    for(const auto & name: opts.phases)
+    {
+        bool found = false;
+        for(const auto & phase: phases)
+            found |= phase.name == name;
+
+        if(!found)
+        {
+            std::cerr<<"Unknown phase: "<<name<<std::endl;
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if(opts.json)
+        std::cout<<"[";
+    else
+        std::cout<<"phase,width,height,cells,reps,min_s,mean_s,cells_per_s,queries_per_s,peak_rss_kb"<<std::endl;
+
+    bool first = true;
+    for(unsigned int size = opts.min_size; size <= opts.max_size; size *= 2)
+    {
+        for(const auto & phase: phases)
+        {
+            if(!opts.phases.empty() &&
+                std::find(opts.phases.begin(), opts.phases.end(), phase.name) == opts.phases.end())
+            {
+                continue;
+            }
+
+            double min_s = std::numeric_limits<double>::max();
+            double total_s = 0.0;
+            reset_peak_rss();
+
+            for(unsigned int rep = 0; rep < opts.reps; ++rep)
+            {
+                double elapsed = phase.run(size, opts.seed + rep);
+                min_s = std::min(min_s, elapsed);
+                total_s += elapsed;
+            }
+
+            long rss_kb = peak_rss_kb();
+
+            double cells = (double)size * size;
+            double cells_per_s = 0.0, queries_per_s = 0.0;
+            if(min_s > 0.0)
+            {
+                if(phase.queries)
+                    queries_per_s = opts.path_queries / min_s;
+                else
+                    cells_per_s = cells / min_s;
+            }
+
+            if(opts.json)
+            {
+                std::cout<<(first ? "\n" : ",\n")
+                    <<"  {\"phase\": \""<<phase.name<<"\", \"width\": "<<size<<", \"height\": "<<size
+                    <<", \"cells\": "<<(unsigned long long)cells<<", \"reps\": "<<opts.reps
+                    <<", \"min_s\": "<<min_s<<", \"mean_s\": "<<total_s / opts.reps
+                    <<", \"cells_per_s\": "<<cells_per_s<<", \"queries_per_s\": "<<queries_per_s<<", \"peak_rss_kb\": "<<rss_kb<<"}"<<std::flush;
+            }
+            else
+            {
+                std::cout<<phase.name<<","<<size<<","<<size<<","<<(unsigned long long)cells<<","<<opts.reps
+                    <<","<<min_s<<","<<total_s / opts.reps<<","<<cells_per_s<<","<<queries_per_s<<","<<rss_kb<<std::endl;
+            }
+            first = false;
+        }
+
+        // don't overflow on the last doubling
+        if(size > std::numeric_limits<unsigned int>::max() / 2)
+            break;
+    }
+
+    if(opts.json)
+        std::cout<<"\n]"<<std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,400 @@
+// main.cpp
+// batch headless maze generation
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+// Generates many mazes at once, spread across worker threads, and writes each
+// to a maze file or PNG image. Statistics for each maze are written as CSV on
+// stdout, in the order the mazes were requested. A maze that fails gets a
+// row with its error, and doesn't stop the others
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+#include "mazegen/grid.hpp"
+#include "mazegen/maze_file.hpp"
+#include "mazegen/maze_stats.hpp"
+#include "util/parallel.hpp"
+
+enum Output_format {FORMAT_MZG, FORMAT_PNG, FORMAT_NONE};
+
+struct Options
+{
+    unsigned int count = 1;
+    std::uint64_t seed = 1;
+    // if not empty, one maze per seed, instead of count from seed
+    std::vector<std::uint64_t> seeds;
+    unsigned int width = 32;
+    unsigned int height = 32;
+    Grid::Mazegen_alg mazegen = Grid::MAZEGEN_DFS;
+    // the game uses 25 & 100 on a 32x32 grid
+    unsigned int room_attempts = 25;
+    unsigned int wall_rm_attempts = 100;
+    unsigned int num_threads = 0;
+    std::string out_dir = ".";
+    Output_format format = FORMAT_MZG;
+    unsigned int cell_px = 4;
+};
+
+struct Result
+{
+    std::uint64_t seed;
+    std::string filename; // empty if nothing was written
+    Maze_stats stats;
+    bool measured = false; // false if generation failed before stats were taken
+    double gen_s = 0.0;
+    std::string error; // empty unless this maze failed
+};
+
+// quote a CSV field if it needs it
+std::string csv_field(const std::string & field)
+{
+    if(field.find_first_of(",\"\n") == std::string::npos)
+        return field;
+
+    std::string quoted = "\"";
+    for(char c: field)
+    {
+        if(c == '"')
+            quoted += '"';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+// one PNG chunk: length, type, data, then CRC of type & data
+void write_png_chunk(std::ofstream & out, const char type[4], const std::vector<unsigned char> & data)
+{
+    auto write_be32 = [&out](const std::uint32_t val)
+    {
+        unsigned char bytes[4] = {(unsigned char)(val >> 24), (unsigned char)(val >> 16),
+            (unsigned char)(val >> 8), (unsigned char)val};
+        out.write((const char *)bytes, 4);
+    };
+
+    write_be32(data.size());
+    out.write(type, 4);
+    out.write((const char *)data.data(), data.size());
+
+    // crc32 with a null buffer returns its initial value, not crc, so skip
+    // it for empty chunks like IEND
+    uLong crc = crc32(0, (const Bytef *)type, 4);
+    if(!data.empty())
+        crc = crc32(crc, data.data(), data.size());
+    write_be32(crc);
+}
+
+// 8-bit grayscale PNG of grid. Each cell, each wall between cells, and each
+// corner where walls meet is a cell_px square, black for walls and white for
+// open
+void write_png(const std::string & filename, const Grid & grid, const unsigned int cell_px)
+{
+    std::uint64_t img_width = (2 * (std::uint64_t)grid.width() + 1) * cell_px;
+    std::uint64_t img_height = (2 * (std::uint64_t)grid.height() + 1) * cell_px;
+    if(img_width > 0x7FFFFFFF || img_height > 0x7FFFFFFF)
+        throw std::invalid_argument("image too large for PNG: " + filename);
+
+    const unsigned char wall = 0x00, open = 0xFF;
+
+    // each image row starts with its filter type (0: none)
+    std::vector<unsigned char> pixels;
+    pixels.reserve((img_width + 1) * img_height);
+    std::vector<unsigned char> row(img_width + 1);
+
+    for(unsigned int y = 0; y < 2 * grid.height() + 1; ++y)
+    {
+        row[0] = 0;
+        for(unsigned int x = 0; x < 2 * grid.width() + 1; ++x)
+        {
+            // odd coordinates are cells, even ones are walls between them
+            unsigned char color = wall;
+            if(x % 2 == 1 && y % 2 == 1)
+                color = open;
+            else if(x % 2 == 1 && y > 0 && y < 2 * grid.height())
+                color = grid.wall(x / 2, y / 2 - 1, DOWN) ? wall : open;
+            else if(y % 2 == 1 && x > 0 && x < 2 * grid.width())
+                color = grid.wall(x / 2 - 1, y / 2, RIGHT) ? wall : open;
+            // corners are open only inside rooms, where all 4 walls meeting there are gone
+            else if(x > 0 && x < 2 * grid.width() && y > 0 && y < 2 * grid.height())
+            {
+                unsigned int cx = x / 2 - 1, cy = y / 2 - 1;
+                bool any_wall = grid.wall(cx, cy, RIGHT) || grid.wall(cx, cy, DOWN) ||
+                    grid.wall(cx + 1, cy + 1, LEFT) || grid.wall(cx + 1, cy + 1, UP);
+                color = any_wall ? wall : open;
+            }
+
+            std::fill(row.begin() + 1 + x * cell_px, row.begin() + 1 + (x + 1) * cell_px, color);
+        }
+
+        for(unsigned int i = 0; i < cell_px; ++i)
+            pixels.insert(pixels.end(), row.begin(), row.end());
+    }
+
+    std::vector<unsigned char> compressed(compressBound(pixels.size()));
+    uLongf compressed_size = compressed.size();
+    if(compress2(compressed.data(), &compressed_size, pixels.data(), pixels.size(), Z_DEFAULT_COMPRESSION) != Z_OK)
+        throw std::runtime_error("Error compressing image: " + filename);
+    compressed.resize(compressed_size);
+
+    std::ofstream out(filename, std::ios_base::binary);
+    if(!out)
+        throw std::runtime_error("Error opening image file: " + filename);
+
+    const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    out.write((const char *)signature, sizeof(signature));
+
+    // width, height, bit depth 8, grayscale, deflate, adaptive filtering, no interlace
+    std::vector<unsigned char> header =
+    {
+        (unsigned char)(img_width >> 24), (unsigned char)(img_width >> 16),
+        (unsigned char)(img_width >> 8), (unsigned char)img_width,
+        (unsigned char)(img_height >> 24), (unsigned char)(img_height >> 16),
+        (unsigned char)(img_height >> 8), (unsigned char)img_height,
+        8, 0, 0, 0, 0
+    };
+    write_png_chunk(out, "IHDR", header);
+    write_png_chunk(out, "IDAT", compressed);
+    write_png_chunk(out, "IEND", {});
+
+    if(!out)
+        throw std::runtime_error("Error writing image file: " + filename);
+}
+
+// generate, measure & save one maze. Runs on a worker thread. Errors are
+// recorded in the result instead of thrown, so one bad maze doesn't lose the
+// rest of the batch
+Result generate(const Options & opts, const std::uint64_t seed)
+{
+    Result result;
+    result.seed = seed;
+
+    std::string filename;
+    try
+    {
+        auto start = std::chrono::steady_clock::now();
+        Grid grid(opts.width, opts.height, opts.mazegen, opts.room_attempts, opts.wall_rm_attempts, seed);
+        result.gen_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        grid.drop_regions(); // not needed for stats or output, so free them before either
+
+        result.stats = get_maze_stats(grid);
+        result.measured = true;
+
+        std::string name = opts.out_dir + "/maze_" + std::to_string(seed);
+        switch(opts.format)
+        {
+        case FORMAT_MZG:
+            filename = name + ".mzg";
+            write_maze_file(filename, grid, opts.mazegen, opts.room_attempts, opts.wall_rm_attempts);
+            break;
+        case FORMAT_PNG:
+            filename = name + ".png";
+            write_png(filename, grid, opts.cell_px);
+            break;
+        case FORMAT_NONE:
+            break;
+        }
+        result.filename = filename;
+    }
+    catch(const std::exception & e)
+    {
+        result.error = e.what();
+    }
+
+    return result;
+}
+
+void usage(const char * prog)
+{
+    std::cerr<<"usage: "<<prog<<" [options]\n"
+        <<"  --count N            number of mazes (default 1)\n"
+        <<"  --seed N             seed of the first maze; maze i uses seed N + i (default 1)\n"
+        <<"  --seeds N,N,...      one maze per listed seed, instead of --count & --seed\n"
+        <<"  --width N            grid width (default 32)\n"
+        <<"  --height N           grid height (default 32)\n"
+        <<"  --alg ALG            maze algorithm: dfs prim kruskal growing division\n"
+        <<"                       (default dfs)\n"
+        <<"  --rooms N            room placement attempts (default 25)\n"
+        <<"  --wall-rm N          random wall removal attempts (default 100)\n"
+        <<"  --threads N          worker threads (default 0: all cores)\n"
+        <<"  --out DIR            existing directory for output files (default .)\n"
+        <<"  --format mzg|png|none  output: maze files, images, or only statistics\n"
+        <<"                       (default mzg). Files are named maze_<seed>.<format>\n"
+        <<"  --cell-px N          pixels per cell & per wall in images (default 4)\n"
+        <<"Writes CSV statistics for each maze on stdout. longest_path_lb is exact for\n"
+        <<"perfect mazes (--rooms 0 --wall-rm 0), and a lower bound otherwise. Mazes\n"
+        <<"that fail are listed with an error, and the exit status is non-zero\n";
+}
+
+bool parse_args(int argc, char * argv[], Options & opts)
+{
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if(arg == "--help" || arg == "-h")
+            return false;
+
+        if(i + 1 >= argc)
+        {
+            std::cerr<<"Missing value for "<<arg<<std::endl;
+            return false;
+        }
+        std::string val = argv[++i];
+
+        try
+        {
+            if(arg == "--count")
+                opts.count = std::stoul(val);
+            else if(arg == "--seed")
+                opts.seed = std::stoull(val);
+            else if(arg == "--seeds")
+            {
+                opts.seeds.clear();
+                for(std::size_t begin = 0; begin <= val.size();)
+                {
+                    std::size_t end = std::min(val.find(',', begin), val.size());
+                    opts.seeds.push_back(std::stoull(val.substr(begin, end - begin)));
+                    begin = end + 1;
+                }
+            }
+            else if(arg == "--width")
+                opts.width = std::stoul(val);
+            else if(arg == "--height")
+                opts.height = std::stoul(val);
+            else if(arg == "--alg" && val == "dfs")
+                opts.mazegen = Grid::MAZEGEN_DFS;
+            else if(arg == "--alg" && val == "prim")
+                opts.mazegen = Grid::MAZEGEN_PRIM;
+            else if(arg == "--alg" && val == "kruskal")
+                opts.mazegen = Grid::MAZEGEN_KRUSKAL;
+            else if(arg == "--alg" && val == "growing")
+                opts.mazegen = Grid::MAZEGEN_GROWING_TREE;
+            else if(arg == "--alg" && val == "division")
+                opts.mazegen = Grid::MAZEGEN_DIVISION;
+            else if(arg == "--rooms")
+                opts.room_attempts = std::stoul(val);
+            else if(arg == "--wall-rm")
+                opts.wall_rm_attempts = std::stoul(val);
+            else if(arg == "--threads")
+                opts.num_threads = std::stoul(val);
+            else if(arg == "--out")
+                opts.out_dir = val;
+            else if(arg == "--format" && (val == "mzg" || val == "png" || val == "none"))
+                opts.format = val == "mzg" ? FORMAT_MZG : val == "png" ? FORMAT_PNG : FORMAT_NONE;
+            else if(arg == "--cell-px")
+                opts.cell_px = std::stoul(val);
+            else
+            {
+                std::cerr<<"Unknown option: "<<arg<<" "<<val<<std::endl;
+                return false;
+            }
+        }
+        catch(const std::logic_error &)
+        {
+            std::cerr<<"Invalid value for "<<arg<<": "<<val<<std::endl;
+            return false;
+        }
+    }
+
+    if(opts.width == 0 || opts.height == 0)
+    {
+        std::cerr<<"Grid size must be positive"<<std::endl;
+        return false;
+    }
+
+    if(opts.cell_px == 0)
+    {
+        std::cerr<<"Pixels per cell must be positive"<<std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char * argv[])
+{
+    Options opts;
+    if(!parse_args(argc, argv, opts))
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::uint64_t> seeds = opts.seeds;
+    if(seeds.empty())
+    {
+        for(unsigned int i = 0; i < opts.count; ++i)
+            seeds.push_back(opts.seed + i);
+    }
+
+    std::vector<Result> results(seeds.size());
+    try
+    {
+        parallel_for(seeds.size(), [&opts, &seeds, &results](const std::size_t i)
+        {
+            results[i] = generate(opts, seeds[i]);
+        }, opts.num_threads);
+    }
+    catch(const std::exception & e)
+    {
+        std::cerr<<e.what()<<std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::size_t failed = 0;
+    std::cout<<"seed,width,height,file,gen_s,dead_ends,junctions,branching_factor,longest_path_lb,error"<<std::endl;
+    for(const auto & result: results)
+    {
+        std::cout<<result.seed<<","<<opts.width<<","<<opts.height<<","<<csv_field(result.filename)<<",";
+        if(result.measured)
+        {
+            std::cout<<result.gen_s<<","<<result.stats.dead_ends<<","<<result.stats.junctions
+                <<","<<result.stats.branching_factor<<","<<result.stats.longest_path_lb;
+        }
+        else
+            std::cout<<",,,,";
+        std::cout<<","<<csv_field(result.error)<<"\n";
+
+        if(!result.error.empty())
+        {
+            std::cerr<<"maze "<<result.seed<<": "<<result.error<<std::endl;
+            ++failed;
+        }
+    }
+    std::cout<<std::flush;
+
+    if(failed > 0)
+    {
+        std::cerr<<failed<<" of "<<results.size()<<" mazes failed"<<std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
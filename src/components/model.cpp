@@ -44,6 +44,7 @@
 
 #include "config.hpp"
 #include "opengl/gl_helpers.hpp"
+#include "opengl/mesh_builder.hpp"
 #include "util/logger.hpp"
 
 Model::~Model()
@@ -85,6 +86,11 @@ void Model::draw(const std::function<void(const Material &)> & set_material) con
     #endif
 }
 
+void Model::draw_visible(const std::function<void(const Material &)> & set_material, const Frustum &) const
+{
+    draw(set_material);
+}
+
 Model::Model(const bool casts_shadow):
     casts_shadow(casts_shadow),
     _vbo(GL_ARRAY_BUFFER),
@@ -217,11 +223,16 @@ Model::Model(const std::string & filename, const bool casts_shadow):
         }
     }
 
-    std::vector<glm::vec3> vert_pos;
-    std::vector<glm::vec2> vert_tex_coords;
-    std::vector<glm::vec3> vert_normals;
-    std::vector<glm::vec3> vert_tangents;
-    std::vector<GLuint> index;
+    // size the buffers for all meshes up front
+    std::size_t num_verts = 0, num_indexes = 0;
+    for(std::size_t mesh_i = 0; mesh_i < ai_scene->mNumMeshes; ++mesh_i)
+    {
+        num_verts += ai_scene->mMeshes[mesh_i]->mNumVertices;
+        num_indexes += 3 * ai_scene->mMeshes[mesh_i]->mNumFaces;
+    }
+
+    Mesh_builder builder;
+    builder.reserve(num_verts, num_indexes);
 
     glm::mat3 rot_mat(glm::rotate(glm::mat4(1.0f), -0.5f * (float)M_PI, glm::vec3(1.0f, 0.0f, 0.0f))); // converts from Z-up to Y-up
 
@@ -245,8 +256,8 @@ Model::Model(const std::string & filename, const bool casts_shadow):
         _meshes.emplace_back();
         Mesh & mesh = _meshes.back();
 
-        mesh.index = sizeof(GLint) * index.size();
-        mesh.base_vert = vert_pos.size();
+        mesh.index = sizeof(GLuint) * builder.num_indexes();
+        mesh.base_vert = builder.num_verts();
 
         if(ai_mesh->mMaterialIndex < _mats.size())
             mesh.mat = &_mats[ai_mesh->mMaterialIndex];
@@ -260,16 +271,14 @@ Model::Model(const std::string & filename, const bool casts_shadow):
         for(std::size_t vert_i = 0; vert_i < ai_mesh->mNumVertices; ++vert_i)
         {
             const aiVector3D & ai_vert = ai_mesh->mVertices[vert_i];
-            vert_pos.push_back(rot_mat * glm::vec3(ai_vert.x, ai_vert.y, ai_vert.z));
-
             const aiVector3D & ai_tex = ai_mesh->mTextureCoords[0][vert_i];
-            vert_tex_coords.push_back(glm::vec2(ai_tex.x, ai_tex.y));
-
             const aiVector3D & ai_norm = ai_mesh->mNormals[vert_i];
-            vert_normals.push_back(rot_mat * glm::vec3(ai_norm.x, ai_norm.y, ai_norm.z));
-
             const aiVector3D & ai_tangent = ai_mesh->mTangents[vert_i];
-            vert_tangents.push_back(rot_mat * glm::vec3(ai_tangent.x, ai_tangent.y, ai_tangent.z));
+
+            builder.add_vert({rot_mat * glm::vec3(ai_vert.x, ai_vert.y, ai_vert.z),
+                glm::vec2(ai_tex.x, ai_tex.y),
+                rot_mat * glm::vec3(ai_norm.x, ai_norm.y, ai_norm.z),
+                rot_mat * glm::vec3(ai_tangent.x, ai_tangent.y, ai_tangent.z)});
         }
 
         // get indexes
@@ -283,50 +292,14 @@ Model::Model(const std::string & filename, const bool casts_shadow):
             }
 
             for(std::size_t i = 0; i < ai_face.mNumIndices; ++i)
-                index.push_back(ai_face.mIndices[i]);
+                builder.add_index(ai_face.mIndices[i]);
 
             mesh.count += ai_face.mNumIndices;
         }
     }
 
     // create OpenGL vertex objects
-    _vao.bind();
-    _vbo.bind();
-
-    glBufferData(_vbo.type(), sizeof(glm::vec3) * vert_pos.size() +
-        sizeof(glm::vec2) * vert_tex_coords.size() +
-        sizeof(glm::vec3) * vert_normals.size() +
-        sizeof(glm::vec3) * vert_tangents.size(), NULL, GL_STATIC_DRAW);
-
-    glBufferSubData(_vbo.type(), 0, sizeof(glm::vec3) * vert_pos.size(), vert_pos.data());
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, NULL);
-    glEnableVertexAttribArray(0);
-
-    glBufferSubData(_vbo.type(), sizeof(glm::vec3) * vert_pos.size(),
-        sizeof(glm::vec2) * vert_tex_coords.size(), vert_tex_coords.data());
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, (const GLvoid *)(sizeof(glm::vec3) * vert_pos.size()));
-    glEnableVertexAttribArray(1);
-
-    glBufferSubData(_vbo.type(), sizeof(glm::vec3) * vert_pos.size() +
-        sizeof(glm::vec2) * vert_tex_coords.size(),
-        sizeof(glm::vec3) * vert_normals.size(), vert_normals.data());
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, (const GLvoid *)(sizeof(glm::vec3) * vert_pos.size() +
-        sizeof(glm::vec2) * vert_tex_coords.size()));
-    glEnableVertexAttribArray(2);
-
-    glBufferSubData(_vbo.type(), sizeof(glm::vec3) * vert_pos.size() +
-        sizeof(glm::vec2) * vert_tex_coords.size() +
-        sizeof(glm::vec3) * vert_normals.size(),
-        sizeof(glm::vec3) * vert_tangents.size(), vert_tangents.data());
-    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 0, (const GLvoid *)(sizeof(glm::vec3) * vert_pos.size() +
-        sizeof(glm::vec2) * vert_tex_coords.size() +
-        sizeof(glm::vec3) * vert_normals.size()));
-    glEnableVertexAttribArray(3);
-
-    _ebo.bind();
-    glBufferData(_ebo.type(), sizeof(GLuint) * index.size(), index.data(), GL_STATIC_DRAW);
-
-    glBindVertexArray(0);
+    builder.upload(_vao, _vbo, _ebo);
 
     check_error("Model::Model");
 }
@@ -33,6 +33,7 @@
 #include "components/component.hpp"
 #include "components/material.hpp"
 #include "opengl/gl_wrappers.hpp"
+#include "util/frustum.hpp"
 
 class Model: public Component, public sf::NonCopyable
 {
@@ -40,6 +41,10 @@ public:
     virtual ~Model();
     static Model * create(const std::string & filename, const bool casts_shadow);
     virtual void draw(const std::function<void(const Material &)> & set_material) const;
+    // draw, skipping parts entirely outside frustum, which is in model space.
+    // Models without finer bounds draw everything
+    virtual void draw_visible(const std::function<void(const Material &)> & set_material,
+        const Frustum & frustum) const;
 
     bool casts_shadow = true;
 
@@ -0,0 +1,345 @@
+// maze_chunks.cpp
+// endless maze, streamed in chunks around the player
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "entities/maze_chunks.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#include "mazegen/maze_chunk.hpp"
+#include "mazegen/maze_row.hpp"
+#include "opengl/gl_helpers.hpp"
+#include "util/logger.hpp"
+#include "world/entity.hpp"
+
+const unsigned int Maze_chunks::chunk_size;
+const int Maze_chunks::load_radius;
+const int Maze_chunks::evict_radius;
+const unsigned int Maze_chunks::uploads_per_update;
+
+Maze_chunks::Chunk_mesh::Chunk_mesh():
+    vbo(GL_ARRAY_BUFFER),
+    ebo(GL_ELEMENT_ARRAY_BUFFER)
+{
+}
+
+Maze_chunks * Maze_chunks::create(const std::uint64_t world_seed)
+{
+    auto chunks_it = Model_cache_locator::get().mdl_index.find("MAZE_CHUNKS");
+    if(chunks_it != Model_cache_locator::get().mdl_index.end())
+    {
+        return dynamic_cast<Maze_chunks *>(chunks_it->second.get());
+    }
+    else
+    {
+        Maze_chunks * chunks = new Maze_chunks(world_seed);
+        Model_cache_locator::get().mdl_index.emplace("MAZE_CHUNKS", std::unique_ptr<Model>(chunks));
+        return chunks;
+    }
+}
+
+Maze_chunks::Maze_chunks(const std::uint64_t world_seed):
+    Model(true),
+    _world_seed(world_seed)
+{
+    _key = "MAZE_CHUNKS";
+    Logger_locator::get()(Logger::DBG, "Creating endless maze, seed: " + std::to_string(world_seed));
+
+    // 2 materials, set once, so the pointers stay valid
+    _mats.push_back(wall_material());
+    _mats.push_back(floor_material());
+
+    _worker = std::thread(&Maze_chunks::worker, this);
+}
+
+Maze_chunks::~Maze_chunks()
+{
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _quit = true;
+    }
+    _cv.notify_all();
+    _worker.join();
+}
+
+void Maze_chunks::draw(const std::function<void(const Material &)> & set_material) const
+{
+    glDisable(GL_CULL_FACE); // TODO: remove when 3D
+
+    // group by material: all walls, then all floors
+    set_material(_mats[0]);
+    for(const auto & chunk: _resident)
+    {
+        chunk.second->vao.bind();
+        glDrawElements(GL_TRIANGLES, chunk.second->wall_count, GL_UNSIGNED_INT, (GLvoid *)0);
+    }
+
+    set_material(_mats[1]);
+    for(const auto & chunk: _resident)
+    {
+        chunk.second->vao.bind();
+        glDrawElements(GL_TRIANGLES, chunk.second->floor_count, GL_UNSIGNED_INT,
+            (GLvoid *)(sizeof(GLuint) * chunk.second->wall_count));
+    }
+
+    glBindVertexArray(0); // TODO: get prev val?
+
+    glEnable(GL_CULL_FACE);
+
+    #ifdef DEBUG
+    check_error("Maze_chunks::Draw");
+    #endif
+}
+
+void Maze_chunks::draw_visible(const std::function<void(const Material &)> & set_material,
+    const Frustum & frustum) const
+{
+    std::vector<const Chunk_mesh *> visible;
+    visible.reserve(_resident.size());
+    for(const auto & chunk: _resident)
+    {
+        glm::vec3 min((float)chunk.second->x * (float)chunk_size, 0.0f, (float)chunk.second->y * (float)chunk_size);
+        if(frustum.intersects(min, min + glm::vec3((float)chunk_size, 1.0f, (float)chunk_size)))
+            visible.push_back(chunk.second.get());
+    }
+
+    glDisable(GL_CULL_FACE); // TODO: remove when 3D
+
+    set_material(_mats[0]);
+    for(const auto & chunk: visible)
+    {
+        chunk->vao.bind();
+        glDrawElements(GL_TRIANGLES, chunk->wall_count, GL_UNSIGNED_INT, (GLvoid *)0);
+    }
+
+    set_material(_mats[1]);
+    for(const auto & chunk: visible)
+    {
+        chunk->vao.bind();
+        glDrawElements(GL_TRIANGLES, chunk->floor_count, GL_UNSIGNED_INT,
+            (GLvoid *)(sizeof(GLuint) * chunk->wall_count));
+    }
+
+    glBindVertexArray(0); // TODO: get prev val?
+
+    glEnable(GL_CULL_FACE);
+
+    #ifdef DEBUG
+    check_error("Maze_chunks::draw_visible");
+    #endif
+}
+
+void Maze_chunks::update(const glm::vec3 & pos)
+{
+    int center_x = (int)std::floor(pos.x / (float)chunk_size);
+    int center_y = (int)std::floor(pos.z / (float)chunk_size);
+
+    // distance in chunks from the player's chunk
+    auto dist = [center_x, center_y](const int x, const int y)
+    {
+        return std::max(std::abs(x - center_x), std::abs(y - center_y));
+    };
+
+    // drop far chunks, keeping their buffers
+    for(auto it = _resident.begin(); it != _resident.end();)
+    {
+        if(dist(it->second->x, it->second->y) > evict_radius)
+        {
+            _free_meshes.push_back(std::move(it->second));
+            it = _resident.erase(it);
+        }
+        else
+            ++it;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+
+        // collect finished chunks
+        std::move(_built.begin(), _built.end(), std::back_inserter(_ready));
+        _built.clear();
+
+        // forget requests we've moved away from
+        for(auto it = _requests.begin(); it != _requests.end();)
+        {
+            if(dist(it->first, it->second) > evict_radius)
+            {
+                _pending.erase(key(it->first, it->second));
+                it = _requests.erase(it);
+            }
+            else
+                ++it;
+        }
+    }
+
+    // upload a limited number of chunks, to keep frame time steady
+    unsigned int num_uploads = 0;
+    while(!_ready.empty() && num_uploads < uploads_per_update)
+    {
+        Built_chunk built = std::move(_ready.front());
+        _ready.pop_front();
+
+        // skip builds no one is waiting on: the chunk was dropped and its key
+        // forgotten, or another build of it is already resident
+        std::uint64_t chunk_key = key(built.x, built.y);
+        if(_pending.erase(chunk_key) == 0 || _resident.count(chunk_key) != 0 ||
+            dist(built.x, built.y) > evict_radius)
+        {
+            continue;
+        }
+
+        std::unique_ptr<Chunk_mesh> mesh;
+        if(_free_meshes.empty())
+        {
+            mesh.reset(new Chunk_mesh);
+        }
+        else
+        {
+            mesh = std::move(_free_meshes.back());
+            _free_meshes.pop_back();
+        }
+
+        mesh->x = built.x;
+        mesh->y = built.y;
+        mesh->wall_count = built.wall_count;
+        mesh->floor_count = built.mesh.num_indexes() - built.wall_count;
+        built.mesh.upload(mesh->vao, mesh->vbo, mesh->ebo, mesh->vbo_capacity, mesh->ebo_capacity);
+
+        _resident.emplace(chunk_key, std::move(mesh));
+        ++num_uploads;
+    }
+
+    // request missing chunks, nearest first
+    std::vector<std::pair<int, int>> requests;
+    for(int radius = 0; radius <= load_radius; ++radius)
+    {
+        for(int y = center_y - radius; y <= center_y + radius; ++y)
+        {
+            for(int x = center_x - radius; x <= center_x + radius; ++x)
+            {
+                if(dist(x, y) != radius)
+                    continue;
+
+                std::uint64_t chunk_key = key(x, y);
+                if(_resident.count(chunk_key) == 0 && _pending.count(chunk_key) == 0)
+                {
+                    _pending.insert(chunk_key);
+                    requests.emplace_back(x, y);
+                }
+            }
+        }
+    }
+
+    if(!requests.empty())
+    {
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+            _requests.insert(_requests.end(), requests.begin(), requests.end());
+        }
+        _cv.notify_one();
+    }
+
+    #ifdef DEBUG
+    check_error("Maze_chunks::update");
+    #endif
+}
+
+std::uint64_t Maze_chunks::key(const int x, const int y)
+{
+    return ((std::uint64_t)(std::uint32_t)x << 32) | (std::uint32_t)y;
+}
+
+void Maze_chunks::worker()
+{
+    while(true)
+    {
+        std::pair<int, int> request;
+        {
+            std::unique_lock<std::mutex> lock(_lock);
+            _cv.wait(lock, [this](){ return _quit || !_requests.empty(); });
+            if(_quit)
+                return;
+
+            request = _requests.front();
+            _requests.pop_front();
+        }
+
+        try
+        {
+            Built_chunk built = build_chunk(request.first, request.second);
+
+            std::lock_guard<std::mutex> lock(_lock);
+            _built.push_back(std::move(built));
+        }
+        catch(const std::exception & e)
+        {
+            Logger_locator::get()(Logger::ERROR, "Error generating maze chunk (" + std::to_string(request.first) +
+                ", " + std::to_string(request.second) + "): " + e.what());
+        }
+    }
+}
+
+Maze_chunks::Built_chunk Maze_chunks::build_chunk(const int x, const int y) const
+{
+    // same room & wall removal density as the 32x32 fixed maze
+    Maze_chunk chunk(_world_seed, x, y, chunk_size, 25 * chunk_size * chunk_size / 1024,
+        100 * chunk_size * chunk_size / 1024);
+
+    Built_chunk built;
+    built.x = x;
+    built.y = y;
+
+    glm::vec3 base((float)x * (float)chunk_size, 0.0f, (float)y * (float)chunk_size);
+
+    // each chunk draws its own top & left edges. the bottom & right ones are
+    // drawn by the neighbors
+    Grid_row_reader rows(chunk.grid());
+    gen_wall_verts(rows, base, &chunk.up_edge(), &chunk.left_edge(), false, built.mesh);
+    built.wall_count = built.mesh.num_indexes();
+
+    // floor, as a quad after the walls
+    float size = (float)chunk_size;
+    glm::vec3 normal(0.0f, 1.0f, 0.0f);
+    glm::vec3 tangent(1.0f, 0.0f, 0.0f);
+    built.mesh.add_quad({base + glm::vec3(0.0f, 0.0f, size), glm::vec2(0.0f, 0.0f), normal, tangent},
+        {base + glm::vec3(size, 0.0f, size), glm::vec2(size, 0.0f), normal, tangent},
+        {base, glm::vec2(0.0f, size), normal, tangent},
+        {base + glm::vec3(size, 0.0f, 0.0f), glm::vec2(size, size), normal, tangent});
+
+    return built;
+}
+
+Entity create_maze_chunks(const std::uint64_t world_seed)
+{
+    Entity chunks(Maze_chunks::create(world_seed),
+        nullptr, // input
+        nullptr, // physics
+        nullptr, // light
+        nullptr); // audio
+
+    return chunks;
+}
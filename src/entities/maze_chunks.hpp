@@ -0,0 +1,122 @@
+// maze_chunks.hpp
+// endless maze, streamed in chunks around the player
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MAZE_CHUNKS_HPP
+#define MAZE_CHUNKS_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "components/model.hpp"
+#include "entities/walls.hpp"
+#include "opengl/mesh_builder.hpp"
+
+// endless maze made of Maze_chunks. Chunks near the player are generated on a
+// background thread and uploaded a few per frame, and chunks left behind are
+// dropped, with their GL buffers kept for reuse. Memory use & per-frame cost
+// stay constant no matter how far the player goes
+class Maze_chunks final: public Model
+{
+public:
+    static Maze_chunks * create(const std::uint64_t world_seed);
+    ~Maze_chunks();
+    void draw(const std::function<void(const Material &)> & set_material) const;
+    void draw_visible(const std::function<void(const Material &)> & set_material,
+        const Frustum & frustum) const;
+
+    // load chunks around pos and drop far ones. call once per frame, from the
+    // thread with the GL context
+    void update(const glm::vec3 & pos);
+
+    // side of a chunk, in cells
+    static const unsigned int chunk_size = 32;
+    // chunks up to this many chunks away from the player's chunk are loaded
+    static const int load_radius = 2;
+    // and those further than this are dropped. larger than load_radius, so
+    // walking back & forth over a chunk edge doesn't reload chunks
+    static const int evict_radius = 3;
+    // chunks uploaded per update
+    static const unsigned int uploads_per_update = 1;
+
+private:
+    struct Chunk_mesh
+    {
+        Chunk_mesh();
+
+        int x, y;
+        GL_vertex_array vao;
+        GL_buffer vbo;
+        GL_buffer ebo;
+        GLsizeiptr vbo_capacity = 0;
+        GLsizeiptr ebo_capacity = 0;
+        // in indexes. The floor's follow the walls'
+        GLsizei wall_count = 0;
+        GLsizei floor_count = 0;
+    };
+
+    // CPU-side chunk, ready for upload
+    struct Built_chunk
+    {
+        int x, y;
+        Mesh_builder mesh;
+        GLsizei wall_count;
+    };
+
+    Maze_chunks(const std::uint64_t world_seed);
+
+    static std::uint64_t key(const int x, const int y);
+
+    void worker();
+    Built_chunk build_chunk(const int x, const int y) const;
+
+    std::uint64_t _world_seed;
+
+    // main thread only
+    std::unordered_map<std::uint64_t, std::unique_ptr<Chunk_mesh>> _resident;
+    std::vector<std::unique_ptr<Chunk_mesh>> _free_meshes;
+    // requested, but not resident yet
+    std::unordered_set<std::uint64_t> _pending;
+    std::deque<Built_chunk> _ready;
+
+    // shared with the worker, guarded by _lock
+    std::mutex _lock;
+    std::condition_variable _cv;
+    std::deque<std::pair<int, int>> _requests;
+    std::deque<Built_chunk> _built;
+    bool _quit = false;
+
+    std::thread _worker;
+};
+
+Entity create_maze_chunks(const std::uint64_t world_seed);
+
+#endif // MAZE_CHUNKS_HPP
@@ -23,14 +23,22 @@
 
 #include "entities/walls.hpp"
 
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 #include <glm/glm.hpp>
 
 #include "config.hpp"
 #include "opengl/gl_helpers.hpp"
 #include "util/logger.hpp"
+#include "util/parallel.hpp"
 #include "world/entity.hpp"
 
-Walls * Walls::create(const unsigned int width, const unsigned int height)
+const unsigned int Walls::chunk_size;
+
+Walls * Walls::create(const unsigned int width, const unsigned int height, const std::uint64_t seed)
 {
     auto walls_it = Model_cache_locator::get().mdl_index.find("WALLS");
     if(walls_it != Model_cache_locator::get().mdl_index.end())
@@ -39,7 +47,7 @@ Walls * Walls::create(const unsigned int width, const unsigned int height)
     }
     else
     {
-        Walls * walls = new Walls(width, height);
+        Walls * walls = new Walls(width, height, seed);
         Model_cache_locator::get().mdl_index.emplace("WALLS", std::unique_ptr<Model>(walls));
         return walls;
     }
@@ -51,7 +59,7 @@ void Walls::draw(const std::function<void(const Material &)> & set_material) con
     _vao.bind();
 
     set_material(*_meshes[0].mat);
-    glDrawArrays(GL_TRIANGLES, 0, _meshes[0].count);
+    glDrawElements(GL_TRIANGLES, _meshes[0].count, GL_UNSIGNED_INT, (GLvoid *)0);
 
     glBindVertexArray(0); // TODO: get prev val?
 
@@ -62,177 +70,457 @@ void Walls::draw(const std::function<void(const Material &)> & set_material) con
     #endif
 }
 
-Walls::Walls(const unsigned int width, const unsigned int height):
-    Model(true),
-    _grid(width, height, Grid::MAZEGEN_DFS, 25, 100)
+// consecutive visible chunks are drawn together
+void Walls::draw_visible(const std::function<void(const Material &)> & set_material,
+    const Frustum & frustum) const
 {
-    _key = "WALLS";
-    Logger_locator::get()(Logger::DBG, "Creating walls");
+    glDisable(GL_CULL_FACE); // TODO: remove when 3D
+    _vao.bind();
 
-    std::vector<glm::vec3> vert_pos;
-    std::vector<glm::vec2> vert_tex_coords;
-    std::vector<glm::vec3> vert_normals;
-    std::vector<glm::vec3> vert_tangents;
+    set_material(*_meshes[0].mat);
 
-    _meshes.emplace_back();
-    Mesh & mesh = _meshes.back();
+    GLsizei first = 0, count = 0;
+    for(const auto & chunk: _chunks)
+    {
+        if(!frustum.intersects(chunk.min, chunk.max))
+            continue;
+
+        if(count > 0 && first + count != chunk.first)
+        {
+            glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, (GLvoid *)(sizeof(GLuint) * first));
+            count = 0;
+        }
+        if(count == 0)
+            first = chunk.first;
+        count += chunk.count;
+    }
+    if(count > 0)
+        glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, (GLvoid *)(sizeof(GLuint) * first));
 
-    glm::vec3 cell_scale(1.0f, 1.0f, 1.0f);
-    glm::vec3 base(-0.5f * (float)_grid.grid[0].size(), 0.0f, -0.5f * (float)_grid.grid.size());
+    glBindVertexArray(0); // TODO: get prev val?
 
-    glm::vec3 left_normal(1.0f, 0.0f, 0.0f);
-    glm::vec3 left_tangent(0.0f, 0.0f, -1.0f);
-    glm::vec3 up_normal(0.0f, 0.0f, 1.0f);
-    glm::vec3 up_tangent(1.0f, 0.0f, 0.0f);
+    glEnable(GL_CULL_FACE);
 
-    // draw border walls
-    for(std::size_t col = 0; col < _grid.grid[0].size(); ++col)
+    #ifdef DEBUG
+    check_error("Walls::draw_visible");
+    #endif
+}
+
+const Grid * Walls::grid() const
+{
+    return _grid.get();
+}
+
+Walls * Walls::create(Maze_row_source & rows)
+{
+    auto walls_it = Model_cache_locator::get().mdl_index.find("WALLS");
+    if(walls_it != Model_cache_locator::get().mdl_index.end())
     {
-        glm::vec3 origin(cell_scale.x * (float)col, 0.0f, cell_scale.z * (float)_grid.grid.size());
-        origin += base;
+        return dynamic_cast<Walls *>(walls_it->second.get());
+    }
+    else
+    {
+        Walls * walls = new Walls(rows);
+        Model_cache_locator::get().mdl_index.emplace("WALLS", std::unique_ptr<Model>(walls));
+        return walls;
+    }
+}
 
-        vert_pos.push_back(origin);
-        vert_pos.push_back(origin + glm::vec3(cell_scale.x, 0.0f, 0.0f));
-        vert_pos.push_back(origin + glm::vec3(0.0f, cell_scale.y, 0.0f));
+Walls::Walls(const unsigned int width, const unsigned int height, const std::uint64_t seed):
+    Model(true),
+    _grid(new Grid(width, height, Grid::MAZEGEN_DFS, 25, 100, seed))
+{
+    // only walls are used from here on
+    _grid->drop_regions();
+    Logger_locator::get()(Logger::DBG, "Maze seed: " + std::to_string(seed));
+    Grid_row_reader rows(*_grid);
+    build(rows);
+}
 
-        vert_pos.push_back(origin + glm::vec3(0.0f, cell_scale.y, 0.0f));
-        vert_pos.push_back(origin + glm::vec3(cell_scale.x, 0.0f, 0.0f));
-        vert_pos.push_back(origin + glm::vec3(cell_scale.x, cell_scale.y, 0.0f));
+Walls::Walls(Maze_row_source & rows):
+    Model(true)
+{
+    build(rows);
+}
+
+namespace
+{
+    const glm::vec3 cell_scale(1.0f, 1.0f, 1.0f);
+
+    // bands of chunks are read & built in batches of at least this many
+    // chunks, so each parallel pass has enough to share out
+    const std::size_t min_batch_chunks = 256;
+    // smaller batches, or any on a single core, are built in one pass on the
+    // calling thread
+    const std::size_t min_parallel_chunks = 16;
+
+    // counts the quads a merge would add, without storing them
+    struct Quad_counter
+    {
+        std::size_t num_quads = 0;
 
-        for(int i = 0; i < 6; ++i)
+        void add_quad(const Vertex &, const Vertex &, const Vertex &, const Vertex &)
         {
-            vert_normals.push_back(up_normal);
-            vert_tangents.push_back(up_tangent);
+            ++num_quads;
         }
+    };
+
+    // writes quads into a resized Mesh_builder, from vert & index on
+    struct Quad_writer
+    {
+        Mesh_builder & mesh;
+        std::size_t vert, index;
+
+        void add_quad(const Vertex & v0, const Vertex & v1, const Vertex & v2, const Vertex & v3)
+        {
+            mesh.set_quad(vert, index, v0, v1, v2, v3);
+            vert += 4;
+            index += 6;
+        }
+    };
+
+    // a quad along the top of row, from col_begin to col_end, facing down
+    // the grid (+z). Texture coords count cells, so the texture still tiles
+    // once per cell
+    template<typename Out>
+    void add_up_wall(const glm::vec3 & base, const unsigned int col_begin, const unsigned int col_end,
+        const unsigned int row, Out & mesh_out)
+    {
+        glm::vec3 origin = base + glm::vec3(cell_scale.x * (float)col_begin, 0.0f, cell_scale.z * (float)row);
+        float length = (float)(col_end - col_begin);
+        glm::vec3 along(cell_scale.x * length, 0.0f, 0.0f);
+        glm::vec3 up(0.0f, cell_scale.y, 0.0f);
+
+        glm::vec3 normal(0.0f, 0.0f, 1.0f);
+        glm::vec3 tangent(1.0f, 0.0f, 0.0f);
+        mesh_out.add_quad({origin, glm::vec2(0.0f, 0.0f), normal, tangent},
+            {origin + along, glm::vec2(length, 0.0f), normal, tangent},
+            {origin + up, glm::vec2(0.0f, 1.0f), normal, tangent},
+            {origin + along + up, glm::vec2(length, 1.0f), normal, tangent});
     }
-    for(std::size_t row = 0; row < _grid.grid.size(); ++row)
+
+    // a quad along the left of col, from row_begin to row_end, facing right
+    // (+x). Texture coords run from row_end back to row_begin, as for a
+    // single cell
+    template<typename Out>
+    void add_left_wall(const glm::vec3 & base, const unsigned int col, const unsigned int row_begin,
+        const unsigned int row_end, Out & mesh_out)
     {
-        glm::vec3 origin(cell_scale.x * (float)_grid.grid[row].size(), 0.0f, cell_scale.z * (float)row);
-        origin += base;
+        glm::vec3 origin = base + glm::vec3(cell_scale.x * (float)col, 0.0f, cell_scale.z * (float)row_begin);
+        float length = (float)(row_end - row_begin);
+        glm::vec3 along(0.0f, 0.0f, cell_scale.z * length);
+        glm::vec3 up(0.0f, cell_scale.y, 0.0f);
+
+        glm::vec3 normal(1.0f, 0.0f, 0.0f);
+        glm::vec3 tangent(0.0f, 0.0f, -1.0f);
+        mesh_out.add_quad({origin + along, glm::vec2(0.0f, 0.0f), normal, tangent},
+            {origin, glm::vec2(length, 0.0f), normal, tangent},
+            {origin + along + up, glm::vec2(0.0f, 1.0f), normal, tangent},
+            {origin + up, glm::vec2(length, 1.0f), normal, tangent});
+    }
 
-        vert_pos.push_back(origin + glm::vec3(0.0f, 0.0f, cell_scale.z));
-        vert_pos.push_back(origin);
-        vert_pos.push_back(origin + glm::vec3(0.0f, cell_scale.y, cell_scale.z));
+    // columns [col_begin, col_begin + width) of a band of buffered rows
+    class Band_reader final: public Maze_row_source
+    {
+    public:
+        Band_reader(const Maze_row * band, const unsigned int num_rows,
+            const unsigned int col_begin, const unsigned int width):
+            _band(band), _num_rows(num_rows), _col_begin(col_begin), _width(width)
+        {}
 
-        vert_pos.push_back(origin + glm::vec3(0.0f, cell_scale.y, cell_scale.z));
-        vert_pos.push_back(origin);
-        vert_pos.push_back(origin + glm::vec3(0.0f, cell_scale.y, 0.0f));
+        unsigned int width() const
+        {
+            return _width;
+        }
 
-        for(int i = 0; i < 6; ++i)
+        unsigned int height() const
         {
-            vert_normals.push_back(left_normal);
-            vert_tangents.push_back(left_tangent);
+            return _num_rows;
         }
-    }
 
-    // draw cell walls
-    for(std::size_t row = 0; row < _grid.grid.size(); ++row)
-    {
-        for(std::size_t col = 0; col < _grid.grid[row].size(); ++col)
+        bool next_row(Maze_row & row_out)
         {
-            glm::vec3 origin(cell_scale.x * (float)col, 0.0f, cell_scale.y * (float)row);
-            origin += base;
+            if(_row == _num_rows)
+                return false;
 
-            if(_grid.grid[row][col].walls[UP])
+            row_out.right.assign(_width, false);
+            row_out.down.assign(_width, false);
+            for(unsigned int col = 0; col < _width; ++col)
             {
-                vert_pos.push_back(origin);
-                vert_pos.push_back(origin + glm::vec3(cell_scale.x, 0.0f, 0.0f));
-                vert_pos.push_back(origin + glm::vec3(0.0f, cell_scale.y, 0.0f));
+                row_out.right.set(col, _band[_row].right.get(_col_begin + col));
+                row_out.down.set(col, _band[_row].down.get(_col_begin + col));
+            }
 
-                vert_pos.push_back(origin + glm::vec3(0.0f, cell_scale.y, 0.0f));
-                vert_pos.push_back(origin + glm::vec3(cell_scale.x, 0.0f, 0.0f));
-                vert_pos.push_back(origin + glm::vec3(cell_scale.x, cell_scale.y, 0.0f));
+            ++_row;
+            return true;
+        }
 
-                for(int i = 0; i < 6; ++i)
-                {
-                    vert_normals.push_back(up_normal);
-                    vert_tangents.push_back(up_tangent);
-                }
-            }
+    private:
+        const Maze_row * _band;
+        unsigned int _num_rows, _col_begin, _width;
+        unsigned int _row = 0;
+    };
 
-            if(_grid.grid[row][col].walls[LEFT])
+    // merge walls into as few quads as possible. See gen_wall_verts
+    template<typename Out>
+    void merge_walls(Maze_row_source & rows, const glm::vec3 & base,
+        const Bit_plane * up_edge, const Bit_plane * left_edge, const bool far_borders,
+        Out & mesh_out)
+    {
+        const unsigned int no_run = 0xFFFFFFFF;
+
+        // first row of the LEFT wall run each column is in, or no_run
+        std::vector<unsigned int> left_run(rows.width(), no_run);
+
+        // merge walls, a row at a time. A cell's UP wall is the DOWN wall of
+        // the cell above, and its LEFT wall is the RIGHT wall of the cell to
+        // its left. Runs of UP walls along a row are finished within the row,
+        // and runs of LEFT walls down a column when a row without one is
+        // reached
+        Maze_row curr_row, prev_row;
+        unsigned int num_rows = 0;
+        for(unsigned int row = 0; rows.next_row(curr_row); ++row, ++num_rows)
+        {
+            unsigned int up_run = no_run;
+            for(unsigned int col = 0; col < rows.width(); ++col)
             {
-                vert_pos.push_back(origin + glm::vec3(0.0f, 0.0f, cell_scale.z));
-                vert_pos.push_back(origin);
-                vert_pos.push_back(origin + glm::vec3(0.0f, cell_scale.y, cell_scale.z));
-
-                vert_pos.push_back(origin + glm::vec3(0.0f, cell_scale.y, cell_scale.z));
-                vert_pos.push_back(origin);
-                vert_pos.push_back(origin + glm::vec3(0.0f, cell_scale.y, 0.0f));
+                bool up_wall = row == 0 ? (!up_edge || up_edge->get(col)) : prev_row.down.get(col);
+                if(up_wall && up_run == no_run)
+                    up_run = col;
+                else if(!up_wall && up_run != no_run)
+                {
+                    add_up_wall(base, up_run, col, row, mesh_out);
+                    up_run = no_run;
+                }
 
-                for(int i = 0; i < 6; ++i)
+                bool left_wall = col == 0 ? (!left_edge || left_edge->get(row)) : curr_row.right.get(col - 1);
+                if(left_wall && left_run[col] == no_run)
+                    left_run[col] = row;
+                else if(!left_wall && left_run[col] != no_run)
                 {
-                    vert_normals.push_back(left_normal);
-                    vert_tangents.push_back(left_tangent);
+                    add_left_wall(base, col, left_run[col], row, mesh_out);
+                    left_run[col] = no_run;
                 }
             }
+            if(up_run != no_run)
+                add_up_wall(base, up_run, rows.width(), row, mesh_out);
+
+            std::swap(curr_row, prev_row);
+        }
+
+        for(unsigned int col = 0; col < rows.width(); ++col)
+        {
+            if(left_run[col] != no_run)
+                add_left_wall(base, col, left_run[col], num_rows, mesh_out);
+        }
+
+        // border walls are each a single run
+        if(far_borders && num_rows > 0)
+        {
+            add_up_wall(base, 0, rows.width(), num_rows, mesh_out);
+            add_left_wall(base, rows.width(), 0, num_rows, mesh_out);
         }
     }
 
-    // add tex coords
-    for(std::size_t i = 0; i < vert_pos.size(); i += 6)
+    // walls of num_cols columns from col_begin, in a band of num_rows rows.
+    // above is the row over the band, or null at the top of the maze. The
+    // bottom & right borders are added if the chunk is on those edges
+    template<typename Out>
+    void chunk_walls(const Maze_row * band, const unsigned int num_rows, const Bit_plane * above,
+        const unsigned int col_begin, const unsigned int num_cols, const bool bottom, const bool right,
+        const glm::vec3 & chunk_base, Out & mesh_out)
     {
-        vert_tex_coords.push_back(glm::vec2(0.0f, 0.0f));
-        vert_tex_coords.push_back(glm::vec2(1.0f, 0.0f));
-        vert_tex_coords.push_back(glm::vec2(0.0f, 1.0f));
+        Bit_plane up_edge, left_edge;
+        if(above)
+        {
+            up_edge.assign(num_cols, false);
+            for(unsigned int col = 0; col < num_cols; ++col)
+                up_edge.set(col, above->get(col_begin + col));
+        }
+        if(col_begin > 0)
+        {
+            left_edge.assign(num_rows, false);
+            for(unsigned int row = 0; row < num_rows; ++row)
+                left_edge.set(row, band[row].right.get(col_begin - 1));
+        }
+
+        Band_reader rows(band, num_rows, col_begin, num_cols);
+        merge_walls(rows, chunk_base, above ? &up_edge : nullptr, col_begin > 0 ? &left_edge : nullptr,
+            false, mesh_out);
 
-        vert_tex_coords.push_back(glm::vec2(0.0f, 1.0f));
-        vert_tex_coords.push_back(glm::vec2(1.0f, 0.0f));
-        vert_tex_coords.push_back(glm::vec2(1.0f, 1.0f));
+        if(bottom)
+            add_up_wall(chunk_base, 0, num_cols, num_rows, mesh_out);
+        if(right)
+            add_left_wall(chunk_base, num_cols, 0, num_rows, mesh_out);
     }
 
-    mesh.count = vert_pos.size();
+}
 
-    _vao.bind();
-    _vbo.bind();
-
-    glBufferData(_vbo.type(), sizeof(glm::vec3) * vert_pos.size() +
-        sizeof(glm::vec2) * vert_tex_coords.size() +
-        sizeof(glm::vec3) * vert_normals.size() +
-        sizeof(glm::vec3) * vert_tangents.size(), NULL, GL_STATIC_DRAW);
-
-    glBufferSubData(_vbo.type(), 0, sizeof(glm::vec3) * vert_pos.size(), vert_pos.data());
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, NULL);
-    glEnableVertexAttribArray(0);
-
-    glBufferSubData(_vbo.type(), sizeof(glm::vec3) * vert_pos.size(),
-        sizeof(glm::vec2) * vert_tex_coords.size(), vert_tex_coords.data());
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, (const GLvoid *)(sizeof(glm::vec3) * vert_pos.size()));
-    glEnableVertexAttribArray(1);
-
-    glBufferSubData(_vbo.type(), sizeof(glm::vec3) * vert_pos.size() +
-        sizeof(glm::vec2) * vert_tex_coords.size(),
-        sizeof(glm::vec3) * vert_normals.size(), vert_normals.data());
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, (const GLvoid *)(sizeof(glm::vec3) * vert_pos.size() +
-        sizeof(glm::vec2) * vert_tex_coords.size()));
-    glEnableVertexAttribArray(2);
-
-    glBufferSubData(_vbo.type(), sizeof(glm::vec3) * vert_pos.size() +
-        sizeof(glm::vec2) * vert_tex_coords.size() +
-        sizeof(glm::vec3) * vert_normals.size(),
-        sizeof(glm::vec3) * vert_tangents.size(), vert_tangents.data());
-    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 0, (const GLvoid *)(sizeof(glm::vec3) * vert_pos.size() +
-        sizeof(glm::vec2) * vert_tex_coords.size() +
-        sizeof(glm::vec3) * vert_normals.size()));
-    glEnableVertexAttribArray(3);
-
-    glBindVertexArray(0);
-
-    _mats.emplace_back();
-    Material & mat = _mats.back();
+void gen_wall_verts(Maze_row_source & rows, const glm::vec3 & base,
+    const Bit_plane * up_edge, const Bit_plane * left_edge, const bool far_borders,
+    Mesh_builder & mesh_out)
+{
+    merge_walls(rows, base, up_edge, left_edge, far_borders, mesh_out);
+}
+
+Material wall_material()
+{
+    Material mat;
     mat.specular_color = glm::vec3(0.1f, 0.1f, 0.1f);
     mat.diffuse_map = Texture_2D::create(check_in_pwd("img/GroundCover.jpg"), GL_RGB8);
     mat.normal_shininess_map = Texture_2D::create(check_in_pwd("img/normals/GroundCover_N.jpg"), GL_RGB8);
     mat.shininess = 500.0f;
+    return mat;
+}
+
+Material floor_material()
+{
+    Material mat;
+    mat.specular_color = glm::vec3(0.1f, 0.1f, 0.1f);
+    mat.diffuse_map = Texture_2D::create(check_in_pwd("mdl/AncientFlooring.jpg"), GL_RGB8);
+    mat.normal_shininess_map = Texture_2D::create(check_in_pwd("mdl/AncientFlooring_N.jpg"), GL_RGB8);
+    mat.shininess = 500.0f;
+    return mat;
+}
+
+void Walls::build(Maze_row_source & rows)
+{
+    _key = "WALLS";
+    Logger_locator::get()(Logger::DBG, "Creating walls");
+
+    if(rows.height() == 0)
+    {
+        Logger_locator::get()(Logger::ERROR, "Can't create walls for an endless maze");
+        throw std::invalid_argument("Can't create walls for an endless maze");
+    }
+
+    glm::vec3 base(-0.5f * (float)rows.width(), 0.0f, -0.5f * (float)rows.height());
+    unsigned int chunks_across = (rows.width() + chunk_size - 1) / chunk_size;
+    unsigned int batch_bands = (unsigned int)std::max<std::size_t>(1, min_batch_chunks / chunks_across);
+
+    // read whole bands of chunk_size rows in batches. With threads to spare,
+    // a batch's chunks are built in 2 parallel passes: count every chunk's
+    // quads, then write them straight into place, at offsets from a prefix
+    // sum of the counts. The output is the same as appending the chunks one
+    // at a time, in order, as is done otherwise
+    std::vector<Maze_row> batch(batch_bands * chunk_size);
+    std::vector<std::size_t> first_quad;
+    Bit_plane prev_down;
+    Mesh_builder builder;
+    for(unsigned int row_begin = 0;; row_begin += batch.size())
+    {
+        unsigned int num_rows = 0;
+        while(num_rows < batch.size() && rows.next_row(batch[num_rows]))
+            ++num_rows;
+        if(num_rows == 0)
+            break;
+
+        bool last_batch = num_rows < batch.size() || row_begin + num_rows >= rows.height();
+        unsigned int num_bands = (num_rows + chunk_size - 1) / chunk_size;
+        std::size_t num_chunks = (std::size_t)num_bands * chunks_across;
+
+        // chunk i is column i % chunks_across of band i / chunks_across. A
+        // chunk's top & left edges are the last row of the band above, and
+        // the column to its left, or the outer border
+        auto bounds = [&](const std::size_t chunk, Chunk & chunk_out)
+        {
+            unsigned int band_row = (chunk / chunks_across) * chunk_size;
+            unsigned int col_begin = (chunk % chunks_across) * chunk_size;
+            chunk_out.min = base + cell_scale * glm::vec3((float)col_begin, 0.0f, (float)(row_begin + band_row));
+            chunk_out.max = chunk_out.min + cell_scale * glm::vec3((float)std::min(chunk_size, rows.width() - col_begin),
+                1.0f, (float)std::min(chunk_size, num_rows - band_row));
+        };
+        auto gen_chunk = [&](const std::size_t chunk, auto & mesh_out)
+        {
+            unsigned int band = chunk / chunks_across;
+            unsigned int band_row = band * chunk_size;
+            unsigned int col_begin = (chunk % chunks_across) * chunk_size;
+
+            const Bit_plane * above = band > 0 ? &batch[band_row - 1].down : (row_begin > 0 ? &prev_down : nullptr);
+            Chunk chunk_box;
+            bounds(chunk, chunk_box);
+
+            chunk_walls(&batch[band_row], std::min(chunk_size, num_rows - band_row), above,
+                col_begin, std::min(chunk_size, rows.width() - col_begin),
+                last_batch && band == num_bands - 1, col_begin + chunk_size >= rows.width(),
+                chunk_box.min, mesh_out);
+        };
+
+        // every quad is 4 vertices & 6 indexes, so chunks are placed by quad
+        first_quad.assign(num_chunks + 1, 0);
+        first_quad[0] = builder.num_verts() / 4;
+        if(num_chunks < min_parallel_chunks || default_num_threads() == 1)
+        {
+            for(std::size_t chunk = 0; chunk < num_chunks; ++chunk)
+            {
+                gen_chunk(chunk, builder);
+                first_quad[chunk + 1] = builder.num_verts() / 4;
+            }
+        }
+        else
+        {
+            parallel_for(num_chunks, [&](const std::size_t chunk)
+            {
+                Quad_counter counter;
+                gen_chunk(chunk, counter);
+                first_quad[chunk + 1] = counter.num_quads;
+            });
+
+            for(std::size_t chunk = 0; chunk < num_chunks; ++chunk)
+                first_quad[chunk + 1] += first_quad[chunk];
+            builder.resize(4 * first_quad[num_chunks], 6 * first_quad[num_chunks]);
 
+            parallel_for(num_chunks, [&](const std::size_t chunk)
+            {
+                Quad_writer writer = {builder, 4 * first_quad[chunk], 6 * first_quad[chunk]};
+                gen_chunk(chunk, writer);
+            });
+        }
+
+        for(std::size_t chunk = 0; chunk < num_chunks; ++chunk)
+        {
+            if(first_quad[chunk + 1] == first_quad[chunk])
+                continue;
+
+            Chunk chunk_box;
+            bounds(chunk, chunk_box);
+            chunk_box.first = (GLsizei)(6 * first_quad[chunk]);
+            chunk_box.count = (GLsizei)(6 * (first_quad[chunk + 1] - first_quad[chunk]));
+            _chunks.push_back(chunk_box);
+        }
+
+        if(last_batch)
+            break;
+
+        prev_down = batch[num_rows - 1].down;
+    }
+
+    _meshes.emplace_back();
+    Mesh & mesh = _meshes.back();
+    mesh.count = builder.num_indexes();
+
+    builder.upload(_vao, _vbo, _ebo);
+
+    _mats.push_back(wall_material());
     mesh.mat = &_mats.back();
 
-    check_error("Walls::Walls");
+    check_error("Walls::build");
+}
+
+Entity create_walls(const unsigned int width, const unsigned int height, const std::uint64_t seed)
+{
+    Entity walls(Walls::create(width, height, seed),
+        nullptr, // input
+        nullptr, // physics
+        nullptr, // light
+        nullptr); // audio
+
+    return walls;
 }
 
-Entity create_walls(const unsigned int width, const unsigned int height)
+Entity create_walls(Maze_row_source & rows)
 {
-    Entity walls(Walls::create(width, height),
+    Entity walls(Walls::create(rows),
         nullptr, // input
         nullptr, // physics
         nullptr, // light
@@ -261,7 +549,7 @@ void Floor::draw(const std::function<void(const Material &)> & set_material) con
     _vao.bind();
 
     set_material(*_meshes[0].mat);
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, _meshes[0].count);
+    glDrawElements(GL_TRIANGLES, _meshes[0].count, GL_UNSIGNED_INT, (GLvoid *)0);
 
     glBindVertexArray(0); // TODO: get prev val?
 
@@ -278,84 +566,22 @@ Floor::Floor(const unsigned int width, const unsigned int height):
     glm::vec2 ll(-0.5f * (float)width, 0.5f * (float)height);
     glm::vec2 ur(0.5f * (float)width, -0.5f * (float)height);
 
-    std::vector<glm::vec3> vert_pos =
-    {
-        glm::vec3(ll.x, 0.0f, ll.y),
-        glm::vec3(ur.x, 0.0f, ll.y),
-        glm::vec3(ll.x, 0.0f, ur.y),
-        glm::vec3(ur.x, 0.0f, ur.y)
-    };
-
-    std::vector<glm::vec2> vert_tex_coords =
-    {
-        glm::vec2(0.0f, 0.0f),
-        glm::vec2((float)width, 0.0f),
-        glm::vec2(0.0f, (float)height),
-        glm::vec2((float)width, (float)height)
-    };
+    glm::vec3 normal(0.0f, 1.0f, 0.0f);
+    glm::vec3 tangent(1.0f, 0.0f, 0.0f);
 
-    std::vector<glm::vec3> vert_normals =
-    {
-        glm::vec3(0.0f, 1.0f, 0.0f),
-        glm::vec3(0.0f, 1.0f, 0.0f),
-        glm::vec3(0.0f, 1.0f, 0.0f),
-        glm::vec3(0.0f, 1.0f, 0.0f)
-    };
-
-    std::vector<glm::vec3> vert_tangents =
-    {
-        glm::vec3(1.0f, 0.0f, 0.0f),
-        glm::vec3(1.0f, 0.0f, 0.0f),
-        glm::vec3(1.0f, 0.0f, 0.0f),
-        glm::vec3(1.0f, 0.0f, 0.0f)
-    };
+    Mesh_builder builder;
+    builder.add_quad({glm::vec3(ll.x, 0.0f, ll.y), glm::vec2(0.0f, 0.0f), normal, tangent},
+        {glm::vec3(ur.x, 0.0f, ll.y), glm::vec2((float)width, 0.0f), normal, tangent},
+        {glm::vec3(ll.x, 0.0f, ur.y), glm::vec2(0.0f, (float)height), normal, tangent},
+        {glm::vec3(ur.x, 0.0f, ur.y), glm::vec2((float)width, (float)height), normal, tangent});
 
     _meshes.emplace_back();
     Mesh & mesh = _meshes.back();
+    mesh.count = builder.num_indexes();
 
-    mesh.count = vert_pos.size();
-
-    _vao.bind();
-    _vbo.bind();
-
-    glBufferData(_vbo.type(), sizeof(glm::vec3) * vert_pos.size() +
-        sizeof(glm::vec2) * vert_tex_coords.size() +
-        sizeof(glm::vec3) * vert_normals.size() +
-        sizeof(glm::vec3) * vert_tangents.size(), NULL, GL_STATIC_DRAW);
-
-    glBufferSubData(_vbo.type(), 0, sizeof(glm::vec3) * vert_pos.size(), vert_pos.data());
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, NULL);
-    glEnableVertexAttribArray(0);
-
-    glBufferSubData(_vbo.type(), sizeof(glm::vec3) * vert_pos.size(),
-        sizeof(glm::vec2) * vert_tex_coords.size(), vert_tex_coords.data());
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, (const GLvoid *)(sizeof(glm::vec3) * vert_pos.size()));
-    glEnableVertexAttribArray(1);
-
-    glBufferSubData(_vbo.type(), sizeof(glm::vec3) * vert_pos.size() +
-        sizeof(glm::vec2) * vert_tex_coords.size(),
-        sizeof(glm::vec3) * vert_normals.size(), vert_normals.data());
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, (const GLvoid *)(sizeof(glm::vec3) * vert_pos.size() +
-        sizeof(glm::vec2) * vert_tex_coords.size()));
-    glEnableVertexAttribArray(2);
-
-    glBufferSubData(_vbo.type(), sizeof(glm::vec3) * vert_pos.size() +
-        sizeof(glm::vec2) * vert_tex_coords.size() +
-        sizeof(glm::vec3) * vert_normals.size(),
-        sizeof(glm::vec3) * vert_tangents.size(), vert_tangents.data());
-    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 0, (const GLvoid *)(sizeof(glm::vec3) * vert_pos.size() +
-        sizeof(glm::vec2) * vert_tex_coords.size() +
-        sizeof(glm::vec3) * vert_normals.size()));
-    glEnableVertexAttribArray(3);
-    glBindVertexArray(0);
-
-    _mats.emplace_back();
-    Material & mat = _mats.back();
-    mat.specular_color = glm::vec3(0.1f, 0.1f, 0.1f);
-    mat.diffuse_map = Texture_2D::create(check_in_pwd("mdl/AncientFlooring.jpg"), GL_RGB8);
-    mat.normal_shininess_map = Texture_2D::create(check_in_pwd("mdl/AncientFlooring_N.jpg"), GL_RGB8);
-    mat.shininess = 500.0f;
+    builder.upload(_vao, _vbo, _ebo);
 
+    _mats.push_back(floor_material());
     mesh.mat = &_mats.back();
 
     check_error("Floor::Floor");
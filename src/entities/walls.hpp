@@ -24,22 +24,68 @@
 #ifndef WALLS_HPP
 #define WALLS_HPP
 
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
 #include "components/model.hpp"
+#include "mazegen/bit_plane.hpp"
 #include "mazegen/grid.hpp"
+#include "mazegen/maze_row.hpp"
+#include "opengl/mesh_builder.hpp"
+
+// append wall quads for each row in rows, with the upper-left corner at
+// base. The top row's UP walls & left column's LEFT walls come from up_edge &
+// left_edge, or are all walls when null. far_borders adds the bottom & right
+// borders. Straight runs of walls are merged into one quad each
+void gen_wall_verts(Maze_row_source & rows, const glm::vec3 & base,
+    const Bit_plane * up_edge, const Bit_plane * left_edge, const bool far_borders,
+    Mesh_builder & mesh_out);
+
+Material wall_material();
+Material floor_material();
 
 class Walls final: public Model
 {
 public:
-    static Walls * create(const unsigned int width, const unsigned int height);
+    static Walls * create(const unsigned int width, const unsigned int height, const std::uint64_t seed);
+    // build walls from a stream of rows, without keeping a grid
+    static Walls * create(Maze_row_source & rows);
     void draw(const std::function<void(const Material &)> & set_material) const;
+    void draw_visible(const std::function<void(const Material &)> & set_material,
+        const Frustum & frustum) const;
+
+    // null when built from rows. Its regions have been dropped
+    const Grid * grid() const;
+
+    // side of a culling chunk, in cells
+    static const unsigned int chunk_size = 16;
 
 private:
-    Walls(const unsigned int width, const unsigned int height);
+    // a chunk_size square of cells (smaller along the far edges), with its
+    // own range of indexes & bounding box. Walls along a chunk's top & left
+    // edges belong to it, and runs of walls are split where they cross chunks
+    struct Chunk
+    {
+        glm::vec3 min, max;
+        GLsizei first; // in indexes
+        GLsizei count;
+    };
+
+    Walls(const unsigned int width, const unsigned int height, const std::uint64_t seed);
+    Walls(Maze_row_source & rows);
+
+    void build(Maze_row_source & rows);
 
-    Grid _grid;
+    std::unique_ptr<Grid> _grid;
+    // in order, so their index ranges are contiguous
+    std::vector<Chunk> _chunks;
 };
 
-Entity create_walls(const unsigned int width, const unsigned int height);
+Entity create_walls(const unsigned int width, const unsigned int height, const std::uint64_t seed);
+Entity create_walls(Maze_row_source & rows);
 
 class Floor final: public Model
 {
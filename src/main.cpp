@@ -23,6 +23,9 @@
 
 #include <atomic>
 #include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
 
 #include "world/world.hpp" // includes SFML, must be included before Xlib
 
@@ -43,8 +46,46 @@ void sigint_handler(int)
     interrupted = true;
 }
 
+struct Options
+{
+    // stream an endless maze around the player, instead of a fixed one
+    bool endless_maze = false;
+};
+
+void usage(const char * prog)
+{
+    std::cerr<<"usage: "<<prog<<" [options]\n"
+        <<"  --endless            play an endless maze, generated around the player\n"
+        <<"  --help               show this message\n";
+}
+
+bool parse_args(int argc, char * argv[], Options & opts)
+{
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if(arg == "--endless")
+            opts.endless_maze = true;
+        else
+        {
+            if(arg != "--help" && arg != "-h")
+                std::cerr<<"Unknown option: "<<arg<<std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
 int main(int argc, char * argv[])
 {
+    Options opts;
+    if(!parse_args(argc, argv, opts))
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
     #ifdef __linux
     XInitThreads(); // needed for multithreaded window access on Linux
     #endif
@@ -71,7 +112,7 @@ int main(int argc, char * argv[])
     Jukebox_locator::init(jukebox.get());
 
     // initialize world - using a pointer so we can destroy it manually
-    std::unique_ptr<World> world(new World);
+    std::unique_ptr<World> world(new World(opts.endless_maze));
 
     Logger_locator::get()(Logger::INFO, "Running...");
     world->game_loop();
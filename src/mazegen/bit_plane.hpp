@@ -0,0 +1,188 @@
+// bit_plane.hpp
+// densely packed array of bits (1 per grid cell)
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef BIT_PLANE_HPP
+#define BIT_PLANE_HPP
+
+#include <cstdint>
+#include <vector>
+
+class Bit_plane final
+{
+public:
+    typedef std::uint64_t Word;
+    static const unsigned int word_bits = 64;
+
+    Bit_plane() = default;
+    Bit_plane(const std::size_t size, const bool val = false);
+
+    void assign(const std::size_t size, const bool val);
+
+    bool get(const std::size_t i) const;
+    void set(const std::size_t i, const bool val);
+    // true if any bit in [begin, end) is set
+    bool any(const std::size_t begin, const std::size_t end) const;
+    // set every bit in [begin, end) to val
+    void fill(const std::size_t begin, const std::size_t end, const bool val);
+    // copy count bits (LSB first) from src to [begin, begin + count). Whole
+    // words at a time, whatever begin's alignment
+    void copy_in(const std::size_t begin, const Word * src, const std::size_t count);
+
+    std::size_t size() const;
+    std::size_t num_words() const;
+
+    // raw word access, for bulk operations
+    Word * data();
+    const Word * data() const;
+
+private:
+    std::vector<Word> _words;
+    std::size_t _size = 0;
+};
+
+// number of set bits in word
+inline unsigned int count_bits(const Bit_plane::Word word)
+{
+    return __builtin_popcountll(word);
+}
+
+// index of the lowest set bit in word, which must not be 0
+inline unsigned int lowest_bit(const Bit_plane::Word word)
+{
+    return __builtin_ctzll(word);
+}
+
+inline Bit_plane::Bit_plane(const std::size_t size, const bool val)
+{
+    assign(size, val);
+}
+
+inline void Bit_plane::assign(const std::size_t size, const bool val)
+{
+    _size = size;
+    _words.assign((size + word_bits - 1) / word_bits, val ? ~(Word)0 : (Word)0);
+}
+
+inline bool Bit_plane::get(const std::size_t i) const
+{
+    return (_words[i / word_bits] >> (i % word_bits)) & 1;
+}
+
+inline void Bit_plane::set(const std::size_t i, const bool val)
+{
+    Word mask = (Word)1 << (i % word_bits);
+    if(val)
+        _words[i / word_bits] |= mask;
+    else
+        _words[i / word_bits] &= ~mask;
+}
+
+inline bool Bit_plane::any(const std::size_t begin, const std::size_t end) const
+{
+    if(begin >= end)
+        return false;
+
+    std::size_t first = begin / word_bits;
+    std::size_t last = (end - 1) / word_bits;
+    Word first_mask = ~(Word)0 << (begin % word_bits);
+    Word last_mask = ~(Word)0 >> (word_bits - 1 - (end - 1) % word_bits);
+
+    if(first == last)
+        return (_words[first] & first_mask & last_mask) != 0;
+
+    if(_words[first] & first_mask)
+        return true;
+    for(std::size_t i = first + 1; i < last; ++i)
+    {
+        if(_words[i])
+            return true;
+    }
+    return (_words[last] & last_mask) != 0;
+}
+
+inline void Bit_plane::fill(const std::size_t begin, const std::size_t end, const bool val)
+{
+    if(begin >= end)
+        return;
+
+    std::size_t first = begin / word_bits;
+    std::size_t last = (end - 1) / word_bits;
+    Word first_mask = ~(Word)0 << (begin % word_bits);
+    Word last_mask = ~(Word)0 >> (word_bits - 1 - (end - 1) % word_bits);
+    Word fill_word = val ? ~(Word)0 : (Word)0;
+
+    if(first == last)
+    {
+        Word mask = first_mask & last_mask;
+        _words[first] = (_words[first] & ~mask) | (fill_word & mask);
+        return;
+    }
+
+    _words[first] = (_words[first] & ~first_mask) | (fill_word & first_mask);
+    for(std::size_t i = first + 1; i < last; ++i)
+        _words[i] = fill_word;
+    _words[last] = (_words[last] & ~last_mask) | (fill_word & last_mask);
+}
+
+inline void Bit_plane::copy_in(const std::size_t begin, const Word * src, const std::size_t count)
+{
+    std::size_t dest = begin / word_bits;
+    unsigned int shift = begin % word_bits;
+
+    for(std::size_t i = 0; i * word_bits < count; ++i)
+    {
+        std::size_t bits_left = count - i * word_bits;
+        Word mask = bits_left >= word_bits ? ~(Word)0 : ((Word)1 << bits_left) - 1;
+        Word bits = src[i] & mask;
+
+        // each source word straddles 2 destination words unless aligned
+        _words[dest + i] = (_words[dest + i] & ~(mask << shift)) | (bits << shift);
+        if(shift > 0 && (mask >> (word_bits - shift)))
+        {
+            Word high_mask = mask >> (word_bits - shift);
+            _words[dest + i + 1] = (_words[dest + i + 1] & ~high_mask) | (bits >> (word_bits - shift));
+        }
+    }
+}
+
+inline std::size_t Bit_plane::size() const
+{
+    return _size;
+}
+
+inline std::size_t Bit_plane::num_words() const
+{
+    return _words.size();
+}
+
+inline Bit_plane::Word * Bit_plane::data()
+{
+    return _words.data();
+}
+
+inline const Bit_plane::Word * Bit_plane::data() const
+{
+    return _words.data();
+}
+
+#endif // BIT_PLANE_HPP
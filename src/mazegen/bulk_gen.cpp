@@ -0,0 +1,196 @@
+// bulk_gen.cpp
+// binary tree & sidewinder: word-at-a-time row generation
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "mazegen/bulk_gen.hpp"
+
+#include <stdexcept>
+
+#include "mazegen/grid.hpp"
+
+namespace
+{
+    // the low bits bits of a word. Masks the cells in a row's last word from
+    // its padding, which is left set, as Bit_plane::assign(size, true) does
+    Bit_plane::Word valid_mask(const unsigned int bits)
+    {
+        return bits >= Bit_plane::word_bits ? ~(Bit_plane::Word)0 : ((Bit_plane::Word)1 << bits) - 1;
+    }
+
+    // the last row of either maze: all right walls open but the border
+    void fill_last_row(const unsigned int width, Maze_row & row_out)
+    {
+        row_out.right.assign(width, false);
+        row_out.right.fill(width - 1, row_out.right.num_words() * Bit_plane::word_bits, true);
+        row_out.down.assign(width, true);
+    }
+}
+
+Binary_tree_gen::Binary_tree_gen(const unsigned int width, const unsigned int height, const std::uint64_t seed):
+    _width(width), _height(height), _prng(seed)
+{
+    if(width == 0)
+    {
+        throw std::invalid_argument("grid_size.x == 0");
+    }
+}
+
+unsigned int Binary_tree_gen::width() const
+{
+    return _width;
+}
+
+unsigned int Binary_tree_gen::height() const
+{
+    return _height;
+}
+
+bool Binary_tree_gen::next_row(Maze_row & row_out)
+{
+    if(_height > 0 && _row >= _height)
+        return false;
+
+    bool last_row = _height > 0 && _row == _height - 1;
+    ++_row;
+
+    if(last_row)
+    {
+        fill_last_row(_width, row_out);
+        return true;
+    }
+
+    row_out.right.assign(_width, true);
+    row_out.down.assign(_width, true);
+
+    // a set bit opens the cell's down wall, a clear one its right wall. The
+    // last cell has no right wall to open
+    std::size_t num_words = row_out.right.num_words();
+    Bit_plane::Word * right = row_out.right.data();
+    Bit_plane::Word * down = row_out.down.data();
+    for(std::size_t i = 0; i < num_words; ++i)
+    {
+        Bit_plane::Word open_down = _prng();
+        right[i] = open_down;
+        down[i] = ~open_down;
+    }
+
+    unsigned int last_bits = _width - (num_words - 1) * Bit_plane::word_bits;
+    Bit_plane::Word last_bit = (Bit_plane::Word)1 << (last_bits - 1);
+    right[num_words - 1] |= last_bit | ~valid_mask(last_bits);
+    down[num_words - 1] = (down[num_words - 1] & ~last_bit) | ~valid_mask(last_bits);
+
+    return true;
+}
+
+void Binary_tree_gen::fill(Grid & grid, const int region)
+{
+    Binary_tree_gen gen(grid.width(), grid.height(), grid.seed());
+    Maze_row row;
+
+    for(unsigned int y = 0; gen.next_row(row); ++y)
+        grid.set_row(y, row, region);
+}
+
+Sidewinder_gen::Sidewinder_gen(const unsigned int width, const unsigned int height, const std::uint64_t seed):
+    _width(width), _height(height), _prng(seed)
+{
+    if(width == 0)
+    {
+        throw std::invalid_argument("grid_size.x == 0");
+    }
+}
+
+unsigned int Sidewinder_gen::width() const
+{
+    return _width;
+}
+
+unsigned int Sidewinder_gen::height() const
+{
+    return _height;
+}
+
+bool Sidewinder_gen::next_row(Maze_row & row_out)
+{
+    if(_height > 0 && _row >= _height)
+        return false;
+
+    bool last_row = _height > 0 && _row == _height - 1;
+    ++_row;
+
+    if(last_row)
+    {
+        fill_last_row(_width, row_out);
+        return true;
+    }
+
+    row_out.right.assign(_width, true);
+    row_out.down.assign(_width, true);
+
+    // a set bit continues the run through the cell's right wall. Runs end at
+    // the clear bits, found a word at a time. Only the start of the current
+    // run carries from one word to the next
+    std::size_t num_words = row_out.right.num_words();
+    unsigned int last_bits = _width - (num_words - 1) * Bit_plane::word_bits;
+    Bit_plane::Word * right = row_out.right.data();
+
+    // 32 random bits per run, to pick its down passage
+    Bit_plane::Word pick_bits = 0;
+    bool pick_bits_left = false;
+
+    std::uint64_t run_start = 0;
+    for(std::size_t i = 0; i < num_words; ++i)
+    {
+        Bit_plane::Word open_right = _prng();
+        if(i == num_words - 1)
+            open_right &= valid_mask(last_bits) >> 1;
+        right[i] = ~open_right;
+
+        for(Bit_plane::Word ends = ~open_right; ends; ends &= ends - 1)
+        {
+            std::uint64_t run_end = i * Bit_plane::word_bits + lowest_bit(ends);
+            if(run_end >= _width)
+                break;
+
+            if(!pick_bits_left)
+                pick_bits = _prng();
+            std::uint64_t pick = ((pick_bits & 0xFFFFFFFF) * (run_end - run_start + 1)) >> 32;
+            pick_bits >>= 32;
+            pick_bits_left = !pick_bits_left;
+
+            row_out.down.set(run_start + pick, false);
+            run_start = run_end + 1;
+        }
+    }
+
+    return true;
+}
+
+void Sidewinder_gen::fill(Grid & grid, const int region)
+{
+    Sidewinder_gen gen(grid.width(), grid.height(), grid.seed());
+    Maze_row row;
+
+    for(unsigned int y = 0; gen.next_row(row); ++y)
+        grid.set_row(y, row, region);
+}
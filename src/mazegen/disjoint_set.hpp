@@ -1,5 +1,5 @@
 // disjoint_set.hpp
-// disjoint set data struct (for Kruskal's Algorithm)
+// disjoint set data structs (for Kruskal's Algorithm)
 
 // Copyright 2015 Matthew Chandler
 
@@ -24,9 +24,78 @@
 #ifndef DISJOINT_SET_HPP
 #define DISJOINT_SET_HPP
 
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
+// disjoint set over dense indices [0, size)
+// uses path halving and union by rank
+// parents are stored in 32 bits, so size must not exceed UINT32_MAX
+class Index_disjoint_set final
+{
+public:
+    Index_disjoint_set(const std::size_t size);
+    std::size_t find_rep(std::size_t a);
+    // returns false if a & b were already in the same set
+    bool union_reps(const std::size_t a, const std::size_t b);
+private:
+    // throws before anything is allocated if size can't be indexed in 32 bits
+    static std::size_t checked_size(const std::size_t size);
+
+    std::vector<std::uint32_t> _parent;
+    std::vector<std::uint8_t> _rank;
+};
+
+inline Index_disjoint_set::Index_disjoint_set(const std::size_t size):
+    _parent(checked_size(size)), _rank(size, 0)
+{
+    for(std::size_t i = 0; i < size; ++i)
+        _parent[i] = i;
+}
+
+inline std::size_t Index_disjoint_set::checked_size(const std::size_t size)
+{
+    if(size > std::numeric_limits<std::uint32_t>::max())
+        throw std::length_error("disjoint set too large for 32-bit indices: " + std::to_string(size));
+    return size;
+}
+
+inline std::size_t Index_disjoint_set::find_rep(std::size_t a)
+{
+    while(_parent[a] != a)
+    {
+        _parent[a] = _parent[_parent[a]];
+        a = _parent[a];
+    }
+    return a;
+}
+
+inline bool Index_disjoint_set::union_reps(const std::size_t a, const std::size_t b)
+{
+    std::size_t a_root = find_rep(a);
+    std::size_t b_root = find_rep(b);
+
+    if(a_root == b_root)
+        return false;
+
+    // compare ranks
+    if(_rank[a_root] < _rank[b_root])
+        _parent[a_root] = b_root;
+    else if(_rank[a_root] > _rank[b_root])
+        _parent[b_root] = a_root;
+    else // equal ranks
+    {
+        _parent[b_root] = a_root;
+        ++_rank[a_root];
+    }
+    return true;
+}
+
+// disjoint set over arbitrary hashable keys. Prefer Index_disjoint_set when
+// keys can be mapped to dense indices
 template <typename T>
 class Disjoint_set final
 {
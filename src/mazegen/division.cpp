@@ -0,0 +1,229 @@
+// division.cpp
+// recursive division maze generation
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "mazegen/grid.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "mazegen/maze_builder.hpp"
+#include "util/parallel.hpp"
+
+namespace
+{
+    // chambers with at most this many cells are divided serially, each as
+    // one task. Larger ones are split before any tasks start
+    const std::size_t task_cells = 1 << 16;
+
+    // passages between cells being filled, one byte per cell in row-major
+    // order. Bytes, not bits, so tasks can write neighboring cells
+    enum: std::uint8_t {OPEN_RIGHT = 1, OPEN_DOWN = 2};
+
+    struct Chamber
+    {
+        unsigned int x, y, width, height;
+        std::uint64_t seed; // only used for chambers larger than task_cells
+    };
+
+    // wall off chamber along a random line across its short side, leaving one
+    // random gap among the passages the line crosses. Chambers 1 cell wide
+    // are left alone. Returns false if not divided
+    bool divide(std::vector<std::uint8_t> & open, const unsigned int grid_width,
+        const Chamber & chamber, Mazegen_rng & prng, Chamber & first, Chamber & second)
+    {
+        if(chamber.width < 2 || chamber.height < 2)
+            return false;
+
+        bool horizontal = chamber.width < chamber.height || (chamber.width == chamber.height && prng() % 2);
+        unsigned int span = horizontal ? chamber.height : chamber.width;
+        unsigned int split = std::uniform_int_distribution<unsigned int>(1, span - 1)(prng);
+
+        // the line is the down walls of one row, or the right walls of one column
+        std::uint8_t side = horizontal ? OPEN_DOWN : OPEN_RIGHT;
+        std::size_t begin = horizontal ?
+            (std::size_t)(chamber.y + split - 1) * grid_width + chamber.x :
+            (std::size_t)chamber.y * grid_width + chamber.x + split - 1;
+        std::size_t stride = horizontal ? 1 : grid_width;
+        unsigned int length = horizontal ? chamber.width : chamber.height;
+
+        unsigned int num_passages = 0;
+        for(unsigned int i = 0; i < length; ++i)
+            num_passages += (open[begin + i * stride] & side) != 0;
+
+        unsigned int gap = num_passages > 0 ?
+            std::uniform_int_distribution<unsigned int>(0, num_passages - 1)(prng) : 0;
+        for(unsigned int i = 0, passage = 0; i < length; ++i)
+        {
+            std::uint8_t & cell = open[begin + i * stride];
+            if((cell & side) && passage++ != gap)
+                cell &= ~side;
+        }
+
+        if(horizontal)
+        {
+            first = {chamber.x, chamber.y, chamber.width, split, 0};
+            second = {chamber.x, chamber.y + split, chamber.width, chamber.height - split, 0};
+        }
+        else
+        {
+            first = {chamber.x, chamber.y, split, chamber.height, 0};
+            second = {chamber.x + split, chamber.y, chamber.width - split, chamber.height, 0};
+        }
+        return true;
+    }
+}
+
+// Starts with passages between all unvisited neighbors, and divides the grid
+// into chambers until they're 1 cell wide. Visited cells (rooms) have no
+// passages, so lines crossing them don't need gaps there. Every line is
+// within its chamber, so chambers past the first few levels are divided in
+// parallel. Each of those gets its own seed, so the maze doesn't depend on
+// the number of threads
+int Grid::fill_mazes_division(int region)
+{
+    std::size_t size = (std::size_t)_width * _height;
+    std::vector<std::uint8_t> open(size, 0);
+
+    for(unsigned int y = 0; y < _height; ++y)
+    {
+        for(unsigned int x = 0; x < _width; ++x)
+        {
+            if(visited(x, y))
+                continue;
+
+            std::uint8_t & cell = open[(std::size_t)y * _width + x];
+            if(x < _width - 1 && !visited(x + 1, y))
+                cell |= OPEN_RIGHT;
+            if(y < _height - 1 && !visited(x, y + 1))
+                cell |= OPEN_DOWN;
+        }
+    }
+
+    // split large chambers in order, each with its own RNG, until the rest
+    // are small enough to be tasks
+    std::vector<Chamber> large = {{0, 0, _width, _height, _prng()}}, tasks;
+    while(!large.empty())
+    {
+        Chamber chamber = large.back();
+        large.pop_back();
+
+        Mazegen_rng prng(chamber.seed);
+        Chamber first, second;
+        if((std::size_t)chamber.width * chamber.height <= task_cells ||
+            !divide(open, _width, chamber, prng, first, second))
+        {
+            tasks.push_back(chamber);
+            continue;
+        }
+
+        first.seed = prng();
+        second.seed = prng();
+        large.push_back(second);
+        large.push_back(first);
+    }
+
+    auto divide_task = [this, &open, &tasks](const std::size_t task)
+    {
+        Mazegen_rng prng(tasks[task].seed);
+        std::vector<Chamber> chambers = {tasks[task]};
+        while(!chambers.empty())
+        {
+            Chamber chamber = chambers.back(), first, second;
+            chambers.pop_back();
+            if(divide(open, _width, chamber, prng, first, second))
+            {
+                chambers.push_back(second);
+                chambers.push_back(first);
+            }
+        }
+    };
+
+    if(tasks.size() == 1)
+        divide_task(0);
+    else
+        parallel_for(tasks.size(), divide_task);
+
+    // carve the passages, and give each connected area its own region. Lines
+    // through rooms can cut an area in two, so there may be several
+    std::vector<sf::Vector2u> stack;
+    for(unsigned int row = 0; row < _height; ++row)
+    {
+        for(unsigned int col = 0; col < _width; ++col)
+        {
+            if(visited(col, row))
+                continue;
+
+            set_visited(col, row, true);
+            set_region(col, row, region);
+            stack.push_back(sf::Vector2u(col, row));
+
+            while(!stack.empty())
+            {
+                sf::Vector2u curr = stack.back();
+                stack.pop_back();
+                std::size_t i = (std::size_t)curr.y * _width + curr.x;
+
+                auto visit = [this, &stack, region](const unsigned int x, const unsigned int y)
+                {
+                    if(visited(x, y))
+                        return;
+                    set_visited(x, y, true);
+                    set_region(x, y, region);
+                    stack.push_back(sf::Vector2u(x, y));
+                };
+
+                if(open[i] & OPEN_RIGHT)
+                {
+                    set_wall(curr.x, curr.y, RIGHT, false);
+                    visit(curr.x + 1, curr.y);
+                }
+                if(open[i] & OPEN_DOWN)
+                {
+                    set_wall(curr.x, curr.y, DOWN, false);
+                    visit(curr.x, curr.y + 1);
+                }
+                if(curr.x > 0 && (open[i - 1] & OPEN_RIGHT))
+                    visit(curr.x - 1, curr.y);
+                if(curr.y > 0 && (open[i - _width] & OPEN_DOWN))
+                    visit(curr.x, curr.y - 1);
+            }
+
+            ++region;
+        }
+    }
+
+    return region;
+}
+
+Division_fill::Division_fill(Grid & grid, const int region):
+    Maze_fill(grid, region)
+{}
+
+bool Division_fill::step(std::size_t & budget)
+{
+    _region = _grid.fill_mazes_division(_region);
+    budget -= std::min(budget, (std::size_t)_grid.width() * _grid.height());
+    return true;
+}
@@ -0,0 +1,142 @@
+// eller.cpp
+// Eller's algorithm: row-streaming maze generation
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mazegen/eller.hpp"
+
+#include <random>
+#include <stdexcept>
+
+#include "mazegen/disjoint_set.hpp"
+#include "mazegen/grid.hpp"
+
+Eller_gen::Eller_gen(const unsigned int width, const unsigned int height, const std::uint64_t seed):
+    _width(width), _height(height), _prng(seed), _sets(width)
+{
+    if(width == 0)
+    {
+        throw std::invalid_argument("grid_size.x == 0");
+    }
+
+    // every cell of the first row starts in its own set
+    for(unsigned int i = 0; i < width; ++i)
+        _sets[i] = i;
+}
+
+unsigned int Eller_gen::width() const
+{
+    return _width;
+}
+
+unsigned int Eller_gen::height() const
+{
+    return _height;
+}
+
+bool Eller_gen::next_row(Maze_row & row_out)
+{
+    if(_height > 0 && _row >= _height)
+        return false;
+
+    bool last_row = _height > 0 && _row == _height - 1;
+    ++_row;
+
+    row_out.right.assign(_width, true);
+    row_out.down.assign(_width, true);
+
+    std::bernoulli_distribution coin(0.5);
+
+    // randomly join adjacent cells in different sets. The last row must join
+    // all of them
+    Index_disjoint_set sets(_width);
+    for(unsigned int col = 0; col + 1 < _width; ++col)
+    {
+        if(sets.find_rep(_sets[col]) != sets.find_rep(_sets[col + 1]) && (last_row || coin(_prng)))
+        {
+            sets.union_reps(_sets[col], _sets[col + 1]);
+            row_out.right.set(col, false);
+        }
+    }
+
+    if(last_row)
+        return true;
+
+    // every set needs at least 1 passage down. open some at random
+    std::vector<unsigned int> rep(_width);
+    std::vector<unsigned int> set_size(_width, 0);
+    std::vector<bool> set_has_down(_width, false);
+
+    for(unsigned int col = 0; col < _width; ++col)
+    {
+        rep[col] = sets.find_rep(_sets[col]);
+        ++set_size[rep[col]];
+
+        if(coin(_prng))
+        {
+            row_out.down.set(col, false);
+            set_has_down[rep[col]] = true;
+        }
+    }
+
+    // for sets that got none, open a randomly chosen cell
+    std::vector<int> pick(_width, -1);
+    for(unsigned int set = 0; set < _width; ++set)
+    {
+        if(set_size[set] > 0 && !set_has_down[set])
+            pick[set] = std::uniform_int_distribution<int>(0, set_size[set] - 1)(_prng);
+    }
+    for(unsigned int col = 0; col < _width; ++col)
+    {
+        if(pick[rep[col]]-- == 0)
+            row_out.down.set(col, false);
+    }
+
+    // label the next row. Cells below a passage stay in their set, the rest
+    // get new sets. Labels are kept compact so they stay below width
+    std::vector<int> relabel(_width, -1);
+    unsigned int next_label = 0;
+    for(unsigned int col = 0; col < _width; ++col)
+    {
+        if(!row_out.down.get(col))
+        {
+            if(relabel[rep[col]] < 0)
+                relabel[rep[col]] = next_label++;
+            _sets[col] = relabel[rep[col]];
+        }
+    }
+    for(unsigned int col = 0; col < _width; ++col)
+    {
+        if(row_out.down.get(col))
+            _sets[col] = next_label++;
+    }
+
+    return true;
+}
+
+void Eller_gen::fill(Grid & grid, const int region)
+{
+    Eller_gen gen(grid.width(), grid.height(), grid.seed());
+    Maze_row row;
+
+    for(unsigned int y = 0; gen.next_row(row); ++y)
+        grid.set_row(y, row, region);
+}
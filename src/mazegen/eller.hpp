@@ -0,0 +1,62 @@
+// eller.hpp
+// Eller's algorithm: row-streaming maze generation
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef ELLER_HPP
+#define ELLER_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "mazegen/maze_row.hpp"
+#include "mazegen/rng.hpp"
+
+class Grid;
+
+// generates a perfect maze one row at a time. Only the current row's set
+// membership is kept, so memory use is proportional to width, and the maze
+// may be arbitrarily tall
+class Eller_gen final: public Maze_row_source
+{
+public:
+    // height 0 generates rows forever
+    Eller_gen(const unsigned int width, const unsigned int height, const std::uint64_t seed);
+
+    unsigned int width() const;
+    unsigned int height() const;
+    bool next_row(Maze_row & row_out);
+
+    // generate a whole maze into an empty grid, as a single region. Seeded
+    // from the grid's seed
+    static void fill(Grid & grid, const int region = 0);
+
+private:
+    unsigned int _width, _height;
+    unsigned int _row = 0;
+
+    Mazegen_rng _prng;
+
+    // set label for each cell of the current row, in [0, width)
+    std::vector<unsigned int> _sets;
+};
+
+#endif // ELLER_HPP
@@ -0,0 +1,424 @@
+// flow_field.cpp
+// distances & directions toward shared targets, for many agents
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "mazegen/flow_field.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "util/parallel.hpp"
+
+namespace
+{
+    // smallest slice of a frontier given to a worker thread. Smaller levels
+    // (most of them, in a maze) are searched on the calling thread
+    const std::size_t min_frontier_chunk = 4096;
+
+    // an update that invalidates more than 1 / this of the cells searches
+    // again from scratch
+    const std::size_t full_search_fraction = 8;
+
+    // UP & DOWN, and LEFT & RIGHT, are adjacent in Direction
+    Direction opposite(const Direction dir)
+    {
+        return (Direction)(dir ^ 1);
+    }
+}
+
+const std::uint32_t Flow_field::unreachable;
+const std::uint8_t Flow_field::no_dir;
+
+Flow_field::Flow_field(const Grid & grid, const std::vector<sf::Vector2u> & targets,
+    const unsigned int num_threads):
+    _width(grid.width()), _height(grid.height()),
+    _num_threads(num_threads == 0 ? default_num_threads() : num_threads)
+{
+    if((std::uint64_t)_width * _height >= unreachable)
+    {
+        throw std::invalid_argument("grid too large for flow field: " +
+            std::to_string(_width) + "x" + std::to_string(_height));
+    }
+
+    std::size_t size = (std::size_t)_width * _height;
+    grid.open_sides(_open_sides);
+    _is_target.assign(size, false);
+    _dist.reset(new std::atomic<std::uint32_t>[size]);
+    _next.resize(size);
+
+    for(const auto & target: targets)
+    {
+        if(target.x >= _width || target.y >= _height)
+        {
+            throw std::out_of_range("flow field target off grid: (" +
+                std::to_string(target.x) + ", " + std::to_string(target.y) + ")");
+        }
+        _targets.push_back(target.y * _width + target.x);
+        _is_target.set(_targets.back(), true);
+    }
+
+    search_all();
+}
+
+void Flow_field::set_targets(const std::vector<sf::Vector2u> & targets)
+{
+    for(const auto & target: targets)
+    {
+        if(target.x >= _width || target.y >= _height)
+        {
+            throw std::out_of_range("flow field target off grid: (" +
+                std::to_string(target.x) + ", " + std::to_string(target.y) + ")");
+        }
+    }
+
+    for(const auto target: _targets)
+        _is_target.set(target, false);
+
+    std::vector<Cell> new_targets;
+    new_targets.reserve(targets.size());
+    for(const auto & target: targets)
+    {
+        new_targets.push_back(target.y * _width + target.x);
+        _is_target.set(new_targets.back(), true);
+    }
+
+    // everything that led to a removed target needs a new route. Added targets
+    // then only pull cells closer
+    for(const auto target: _targets)
+    {
+        if(!_is_target.get(target) && dist(target) == 0)
+            invalidate_subtree(target);
+    }
+    for(const auto target: new_targets)
+        add_seed(target, 0);
+
+    _targets.swap(new_targets);
+    repair();
+}
+
+void Flow_field::update_wall(const Grid & grid, const unsigned int x, const unsigned int y, const Direction dir)
+{
+    if(grid.width() != _width || grid.height() != _height)
+        throw std::invalid_argument("flow field grid size changed");
+    if(x >= _width || y >= _height)
+    {
+        throw std::out_of_range("flow field wall off grid: (" +
+            std::to_string(x) + ", " + std::to_string(y) + ")");
+    }
+
+    // border walls never change
+    if((dir == UP && y == 0) || (dir == DOWN && y == _height - 1) ||
+        (dir == LEFT && x == 0) || (dir == RIGHT && x == _width - 1))
+    {
+        return;
+    }
+
+    Cell a = y * _width + x;
+    Cell b = step(a, dir);
+    bool now_open = !grid.wall(x, y, dir);
+    if(now_open == open(a, dir))
+        return;
+
+    _open_sides[a] ^= 1 << dir;
+    _open_sides[b] ^= 1 << opposite(dir);
+
+    if(now_open)
+    {
+        // a shortcut: only pulls cells closer
+        if(dist(a) != unreachable)
+            add_seed(b, dist(a) + 1);
+        if(dist(b) != unreachable)
+            add_seed(a, dist(b) + 1);
+    }
+    else
+    {
+        // cut: whichever side stepped through the wall needs a new route
+        if(_next[a] == dir)
+            invalidate_subtree(a);
+        else if(_next[b] == opposite(dir))
+            invalidate_subtree(b);
+    }
+
+    // either cell may now prefer a different direction, even if no distance
+    // changed
+    _changed.push_back(a);
+    _changed.push_back(b);
+    repair();
+}
+
+void Flow_field::update_walls(const Grid & grid)
+{
+    if(grid.width() != _width || grid.height() != _height)
+        throw std::invalid_argument("flow field grid size changed");
+
+    grid.open_sides(_open_sides);
+    search_all();
+}
+
+// level by level breadth-first search from all targets. Large levels are
+// split among worker threads, which claim cells by swapping their distance
+// from unreachable. A cell's direction only depends on the level before it,
+// which is complete, so the result doesn't depend on which thread claims it
+void Flow_field::search_all()
+{
+    std::size_t size = (std::size_t)_width * _height;
+    for(std::size_t i = 0; i < size; ++i)
+        set_dist(i, unreachable);
+    std::fill(_next.begin(), _next.end(), no_dir);
+
+    std::vector<Cell> frontier, next_frontier;
+    for(const auto target: _targets)
+    {
+        if(dist(target) != 0)
+        {
+            set_dist(target, 0);
+            frontier.push_back(target);
+        }
+    }
+
+    std::vector<std::vector<Cell>> chunk_frontiers;
+    for(std::uint32_t level = 0; !frontier.empty(); ++level)
+    {
+        next_frontier.clear();
+
+        std::size_t num_chunks = std::min<std::size_t>(_num_threads, frontier.size() / min_frontier_chunk);
+        if(num_chunks > 1)
+        {
+            // each chunk appends to its own frontier, joined in order after
+            chunk_frontiers.resize(num_chunks);
+            parallel_for(num_chunks, [&](const std::size_t chunk)
+            {
+                chunk_frontiers[chunk].clear();
+                search_level(frontier, frontier.size() * chunk / num_chunks,
+                    frontier.size() * (chunk + 1) / num_chunks, level, true, chunk_frontiers[chunk]);
+            }, _num_threads);
+
+            for(const auto & chunk_frontier: chunk_frontiers)
+                next_frontier.insert(next_frontier.end(), chunk_frontier.begin(), chunk_frontier.end());
+        }
+        else
+            search_level(frontier, 0, frontier.size(), level, false, next_frontier);
+
+        frontier.swap(next_frontier);
+    }
+}
+
+// claim the unvisited neighbors of frontier[begin, end), which are at distance
+// dist, for the next level. Set shared when other threads are claiming too
+void Flow_field::search_level(const std::vector<Cell> & frontier, const std::size_t begin, const std::size_t end,
+    const std::uint32_t dist, const bool shared, std::vector<Cell> & next_frontier)
+{
+    for(std::size_t i = begin; i < end; ++i)
+    {
+        Cell cell = frontier[i];
+        for(Direction dir: {UP, DOWN, LEFT, RIGHT})
+        {
+            if(!open(cell, dir))
+                continue;
+
+            Cell neighbor = step(cell, dir);
+            if(this->dist(neighbor) != unreachable)
+                continue;
+
+            bool claimed = true;
+            if(shared)
+            {
+                std::uint32_t expected = unreachable;
+                claimed = _dist[neighbor].compare_exchange_strong(expected, dist + 1, std::memory_order_relaxed);
+            }
+            else
+                set_dist(neighbor, dist + 1);
+
+            if(claimed)
+            {
+                _next[neighbor] = best_dir(neighbor);
+                next_frontier.push_back(neighbor);
+            }
+        }
+    }
+}
+
+// forget the distance of root & every cell whose steps lead through it.
+// Gives up once repair would search from scratch anyway
+void Flow_field::invalidate_subtree(const Cell root)
+{
+    std::size_t limit = (std::size_t)_width * _height / full_search_fraction;
+
+    _stack.push_back(root);
+    while(!_stack.empty())
+    {
+        if(_changed.size() > limit)
+        {
+            _stack.clear();
+            return;
+        }
+
+        Cell cell = _stack.back();
+        _stack.pop_back();
+
+        set_dist(cell, unreachable);
+        _next[cell] = no_dir;
+        _changed.push_back(cell);
+
+        for(Direction dir: {UP, DOWN, LEFT, RIGHT})
+        {
+            if(open(cell, dir) && _next[step(cell, dir)] == opposite(dir))
+                _stack.push_back(step(cell, dir));
+        }
+    }
+}
+
+void Flow_field::add_seed(const Cell cell, const std::uint32_t dist)
+{
+    if(dist < this->dist(cell))
+    {
+        set_dist(cell, dist);
+        _changed.push_back(cell);
+        _seeds.emplace_back(dist, cell);
+    }
+}
+
+// finish an incremental update. Invalidated cells are seeded from their
+// still valid neighbors, then all seeds spread outward in order of distance
+// (merging the sorted seeds with a FIFO queue, as every edge costs 1), for as
+// long as they shorten distances. Finally, the direction of each changed cell
+// & its neighbors is chosen again
+void Flow_field::repair()
+{
+    // past this, nearly everything will change anyway (as when the only
+    // target moves), and a full search is cheaper
+    if(_changed.size() > (std::size_t)_width * _height / full_search_fraction)
+    {
+        _changed.clear();
+        _seeds.clear();
+        search_all();
+        return;
+    }
+
+    std::size_t num_changed = _changed.size();
+    for(std::size_t i = 0; i < num_changed; ++i)
+    {
+        Cell cell = _changed[i];
+        if(_is_target.get(cell))
+        {
+            add_seed(cell, 0);
+            continue;
+        }
+
+        for(Direction dir: {UP, DOWN, LEFT, RIGHT})
+        {
+            if(open(cell, dir) && dist(step(cell, dir)) != unreachable)
+                add_seed(cell, dist(step(cell, dir)) + 1);
+        }
+    }
+
+    std::sort(_seeds.begin(), _seeds.end());
+
+    // a queued cell's distance can't shrink, as everything popped after it
+    // is at least as far. A seed's can, in which case it's skipped
+    std::size_t seed_i = 0, queue_i = 0;
+    while(seed_i < _seeds.size() || queue_i < _queue.size())
+    {
+        Cell cell;
+        std::uint32_t cell_dist;
+        if(queue_i == _queue.size() || (seed_i < _seeds.size() && _seeds[seed_i].first <= dist(_queue[queue_i])))
+        {
+            cell_dist = _seeds[seed_i].first;
+            cell = _seeds[seed_i++].second;
+            if(cell_dist != dist(cell))
+                continue;
+        }
+        else
+        {
+            cell = _queue[queue_i++];
+            cell_dist = dist(cell);
+        }
+
+        for(Direction dir: {UP, DOWN, LEFT, RIGHT})
+        {
+            if(!open(cell, dir))
+                continue;
+
+            Cell neighbor = step(cell, dir);
+            if(cell_dist + 1 < dist(neighbor))
+            {
+                set_dist(neighbor, cell_dist + 1);
+                _changed.push_back(neighbor);
+                _queue.push_back(neighbor);
+            }
+        }
+    }
+
+    for(const auto cell: _changed)
+    {
+        _next[cell] = best_dir(cell);
+        for(Direction dir: {UP, DOWN, LEFT, RIGHT})
+        {
+            if(open(cell, dir))
+                _next[step(cell, dir)] = best_dir(step(cell, dir));
+        }
+    }
+
+    _changed.clear();
+    _seeds.clear();
+    _queue.clear();
+}
+
+// first direction that leads one step closer, or no_dir for targets &
+// unreachable cells
+std::uint8_t Flow_field::best_dir(const Cell cell) const
+{
+    std::uint32_t cell_dist = dist(cell);
+    if(cell_dist == 0 || cell_dist == unreachable)
+        return no_dir;
+
+    for(Direction dir: {UP, DOWN, LEFT, RIGHT})
+    {
+        if(open(cell, dir) && dist(step(cell, dir)) == cell_dist - 1)
+            return dir;
+    }
+    return no_dir;
+}
+
+inline bool Flow_field::open(const Cell cell, const Direction dir) const
+{
+    return _open_sides[cell] & (1 << dir);
+}
+
+// neighbor of cell, which must be open on that side
+inline Flow_field::Cell Flow_field::step(const Cell cell, const Direction dir) const
+{
+    switch(dir)
+    {
+    case UP:
+        return cell - _width;
+    case DOWN:
+        return cell + _width;
+    case LEFT:
+        return cell - 1;
+    case RIGHT:
+    default:
+        return cell + 1;
+    }
+}
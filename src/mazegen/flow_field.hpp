@@ -0,0 +1,148 @@
+// flow_field.hpp
+// distances & directions toward shared targets, for many agents
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef FLOW_FIELD_HPP
+#define FLOW_FIELD_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <SFML/System.hpp>
+
+#include "mazegen/bit_plane.hpp"
+#include "mazegen/grid.hpp"
+
+// distance from every cell of a grid to the nearest of a set of targets, and
+// the direction to step in to get closer. Built with a single breadth-first
+// search from all targets at once, so any number of agents heading for the
+// same targets can look up their next move in constant time.
+// When targets move or walls change, only the cells whose distance changes
+// are revisited. The result is always the same as a fresh search: distances
+// are exact, and each cell steps in the first of UP, DOWN, LEFT, RIGHT that
+// leads one closer. Not thread safe, though a full search can use several
+// threads itself
+class Flow_field final
+{
+public:
+    static const std::uint32_t unreachable = 0xFFFFFFFF;
+
+    // num_threads workers split each step of a full search's frontier, when
+    // it's large enough to be worth it (0 for hardware concurrency)
+    Flow_field(const Grid & grid, const std::vector<sf::Vector2u> & targets,
+        const unsigned int num_threads = 1);
+
+    // replace the targets. Throws std::out_of_range if any are off the grid
+    void set_targets(const std::vector<sf::Vector2u> & targets);
+
+    // re-read one wall (as for Grid::wall) after it was changed on the grid
+    void update_wall(const Grid & grid, const unsigned int x, const unsigned int y, const Direction dir);
+    // re-read all walls and search again from scratch. The grid must be the
+    // same size as before
+    void update_walls(const Grid & grid);
+
+    // steps to the nearest target, or unreachable
+    std::uint32_t distance(const unsigned int x, const unsigned int y) const;
+    // direction to step from (x, y) toward the nearest target. Returns false if
+    // (x, y) is a target, or no target can be reached
+    bool next_step(const unsigned int x, const unsigned int y, Direction & dir) const;
+
+    unsigned int width() const;
+    unsigned int height() const;
+
+private:
+    typedef std::uint32_t Cell;
+    static const std::uint8_t no_dir = 0xFF;
+
+    void search_all();
+    void search_level(const std::vector<Cell> & frontier, const std::size_t begin, const std::size_t end,
+        const std::uint32_t dist, const bool shared, std::vector<Cell> & next_frontier);
+
+    void invalidate_subtree(const Cell root);
+    void add_seed(const Cell cell, const std::uint32_t dist);
+    void repair();
+
+    std::uint8_t best_dir(const Cell cell) const;
+    std::uint32_t dist(const Cell cell) const;
+    void set_dist(const Cell cell, const std::uint32_t dist);
+    bool open(const Cell cell, const Direction dir) const;
+    Cell step(const Cell cell, const Direction dir) const;
+
+    unsigned int _width, _height;
+    unsigned int _num_threads;
+
+    std::vector<std::uint8_t> _open_sides; // from Grid::open_sides
+    std::vector<Cell> _targets;
+    Bit_plane _is_target;
+
+    // atomic so a full search's workers can claim cells. Only relaxed
+    // accesses are used; the threads are joined between levels
+    std::unique_ptr<std::atomic<std::uint32_t>[]> _dist;
+    std::vector<std::uint8_t> _next; // Direction, or no_dir
+
+    // scratch for incremental repairs, kept between calls
+    std::vector<Cell> _stack;
+    std::vector<std::pair<std::uint32_t, Cell>> _seeds;
+    std::vector<Cell> _queue;
+    std::vector<Cell> _changed;
+};
+
+inline std::uint32_t Flow_field::distance(const unsigned int x, const unsigned int y) const
+{
+    return dist(y * _width + x);
+}
+
+inline bool Flow_field::next_step(const unsigned int x, const unsigned int y, Direction & dir) const
+{
+    std::uint8_t next = _next[y * _width + x];
+    if(next == no_dir)
+        return false;
+
+    dir = (Direction)next;
+    return true;
+}
+
+inline unsigned int Flow_field::width() const
+{
+    return _width;
+}
+
+inline unsigned int Flow_field::height() const
+{
+    return _height;
+}
+
+inline std::uint32_t Flow_field::dist(const Cell cell) const
+{
+    return _dist[cell].load(std::memory_order_relaxed);
+}
+
+inline void Flow_field::set_dist(const Cell cell, const std::uint32_t dist)
+{
+    _dist[cell].store(dist, std::memory_order_relaxed);
+}
+
+#endif // FLOW_FIELD_HPP
@@ -24,220 +24,302 @@
 #include "mazegen/grid.hpp"
 
 #include <algorithm>
-#include <functional>
+#include <cstdint>
+#include <memory>
 #include <random>
+#include <stdexcept>
+#include <string>
 
 #include "mazegen/disjoint_set.hpp"
+#include "mazegen/growing_tree.hpp"
+#include "mazegen/maze_builder.hpp"
+#include "util/parallel.hpp"
 
-extern thread_local std::mt19937 prng;
+// binomial(n, 0.5) sample, as the number of heads in n coin flips. Much
+// cheaper than std::binomial_distribution for small n
+unsigned int coin_flips(Mazegen_rng & prng, const unsigned int n)
+{
+    Mazegen_rng::result_type bits = prng() & (((Mazegen_rng::result_type)1 << n) - 1);
+    unsigned int heads = 0;
+    for(; bits; bits &= bits - 1)
+        ++heads;
+    return heads;
+}
 
-bool attempt_gen_room(const std::vector<std::vector<Grid_cell>> & grid,
+bool attempt_gen_room(const Grid & grid, Mazegen_rng & prng,
     sf::Vector2u & pos_out, sf::Vector2u & size_out)
 {
-    size_out = sf::Vector2u(std::binomial_distribution<unsigned int>(std::min(9u, (unsigned int)(grid[0].size() - 1)), 0.5)(prng) + 1,
-        std::binomial_distribution<unsigned int>(std::min(9u, (unsigned int)(grid.size() - 1)), 0.5)(prng) + 1);
+    size_out = sf::Vector2u(coin_flips(prng, std::min(9u, grid.width() - 1)) + 1,
+        coin_flips(prng, std::min(9u, grid.height() - 1)) + 1);
 
     // discard skinny rooms
     if((float)size_out.x / (float)size_out.y > 4 || (float)size_out.y / (float)size_out.x > 4)
         return false;
 
-    pos_out = sf::Vector2u(std::uniform_int_distribution<unsigned int>(0, std::max(0, (int)grid[0].size() - (int)size_out.x - 1))(prng),
-        std::uniform_int_distribution<unsigned int>(0, std::max(0, (int)grid.size() - (int)size_out.y - 1))(prng));
+    pos_out = sf::Vector2u(std::uniform_int_distribution<unsigned int>(0, std::max(0, (int)grid.width() - (int)size_out.x - 1))(prng),
+        std::uniform_int_distribution<unsigned int>(0, std::max(0, (int)grid.height() - (int)size_out.y - 1))(prng));
 
     // check if overlapping
-    for(std::size_t row = pos_out.y; row < pos_out.y + size_out.y; ++row)
-    {
-        for(std::size_t col = pos_out.x; col < pos_out.x + size_out.x; ++col)
-        {
-            if(grid[row][col].visited)
-            {
-                return false;
-            }
-        }
-    }
-
-    return true;
+    return !grid.any_visited(pos_out.x, pos_out.y, pos_out.x + size_out.x, pos_out.y + size_out.y);
 }
 
-void place_room(std::vector<std::vector<Grid_cell>> & grid,
-    const sf::Vector2u & pos, const sf::Vector2u & size, const int region)
+void place_room(Grid & grid, const sf::Vector2u & pos, const sf::Vector2u & size, const int region)
 {
     // mark visited
     // destroy walls, excepting room borders
-    for(std::size_t row = pos.y; row < pos.y + size.y; ++row)
+    for(unsigned int row = pos.y; row < pos.y + size.y; ++row)
     {
-        for(std::size_t col = pos.x; col < pos.x + size.x; ++col)
+        for(unsigned int col = pos.x; col < pos.x + size.x; ++col)
         {
-            grid[row][col].visited = true;
-            grid[row][col].region = region;
-            grid[row][col].room = true;
+            grid.set_visited(col, row, true);
+            grid.set_region(col, row, region);
+            grid.set_room(col, row, true);
 
-            if(row > pos.y)
-                grid[row][col].walls[UP] = false;
+            // walls are shared, so only the right & down walls need clearing
             if(row < pos.y + size.y - 1)
-                grid[row][col].walls[DOWN] = false;
-            if(col > pos.x)
-                grid[row][col].walls[LEFT] = false;
+                grid.set_wall(col, row, DOWN, false);
             if(col < pos.x + size.x - 1)
-                grid[row][col].walls[RIGHT] = false;
+                grid.set_wall(col, row, RIGHT, false);
         }
     }
 }
 
-std::vector<Wall> find_connectors(const std::vector<std::vector<Grid_cell>> & grid)
+// append the connectors in one row, given its regions & those of the row
+// below (null for the last row). Branch-free: every candidate is written, and
+// the count only advances past real connectors. out must have room for
+// 2 * width entries
+std::size_t scan_connector_row(const int * row, const int * next_row, const unsigned int width,
+    const std::uint64_t first_cell, std::uint64_t * out)
 {
-    std::vector<Wall> connectors;
-    for(std::size_t row = 0; row < grid.size() - 1; ++row)
+    std::size_t count = 0;
+    if(next_row)
     {
-        for(std::size_t col = 0; col < grid[0].size() - 1; ++col)
+        for(unsigned int x = 0; x < width - 1; ++x)
         {
-            if(grid[row][col].region != grid[row][col + 1].region)
-            {
-                sf::Vector2u cell_1(col, row);
-                sf::Vector2u cell_2(col + 1, row);
-                int region_1 = grid[row][col].region;
-                int region_2 = grid[row][col + 1].region;
-
-                connectors.push_back({cell_1, cell_2, RIGHT, LEFT, region_1, region_2});
-            }
-            if(grid[row][col].region != grid[row + 1][col].region)
-            {
-                sf::Vector2u cell_1(col, row);
-                sf::Vector2u cell_2(col, row + 1);
-                int region_1 = grid[row][col].region;
-                int region_2 = grid[row + 1][col].region;
-
-                connectors.push_back({cell_1, cell_2, DOWN, UP, region_1, region_2});
-            }
+            out[count] = (first_cell + x) * 2;
+            count += row[x] != row[x + 1];
+            out[count] = (first_cell + x) * 2 + 1;
+            count += row[x] != next_row[x];
         }
+        out[count] = (first_cell + width - 1) * 2 + 1;
+        count += row[width - 1] != next_row[width - 1];
     }
-    return connectors;
+    else
+    {
+        for(unsigned int x = 0; x < width - 1; ++x)
+        {
+            out[count] = (first_cell + x) * 2;
+            count += row[x] != row[x + 1];
+        }
+    }
+    return count;
 }
 
-void join_regions(std::vector<std::vector<Grid_cell>> & grid,
-    const unsigned int num_regions)
+// find connectors (walls between cells of different regions), as edge IDs:
+// (y * width + x) * 2 for the wall right of (x, y), + 1 for the wall below it.
+// Blocks of rows are scanned in parallel into their own buffers, and joined in
+// order, so the result is the same for any number of threads
+std::vector<std::uint64_t> find_connectors(const Grid & grid)
 {
-    // find connectors (walls that separate 2 different regions
-    std::vector<Wall> connectors = find_connectors(grid);
-
-    // shuffle connectors
-    std::shuffle(connectors.begin(), connectors.end(), prng);
-
-    // use Kruskal's alg to find min spanning tree of region graph
-    std::vector<int> regions_vec(num_regions);
-    for(std::size_t i = 0; i < regions_vec.size(); ++i)
-        regions_vec[i] = i;
-
-    Disjoint_set<int>regions(regions_vec);
+    // big enough blocks that small grids don't start any threads
+    const unsigned int rows_per_block = std::max(1u, (1u << 16) / grid.width());
+    const std::size_t num_blocks = (grid.height() + rows_per_block - 1) / rows_per_block;
+    std::vector<std::vector<std::uint64_t>> block_connectors(num_blocks);
 
-    int num_sets = num_regions;
-    for(const auto & conn: connectors)
+    auto scan_block = [&grid, &block_connectors, rows_per_block](const std::size_t block)
     {
-        int set_1 = regions.find_rep(conn.region_1);
-        int set_2 = regions.find_rep(conn.region_2);
+        unsigned int y_begin = block * rows_per_block;
+        unsigned int y_end = std::min(grid.height(), y_begin + rows_per_block);
 
-        if(set_1 != set_2)
+        std::vector<int> row_buf, next_buf;
+        std::vector<std::uint64_t> scratch(2 * grid.width());
+        std::vector<std::uint64_t> & connectors = block_connectors[block];
+
+        const int * row = grid.region_row(y_begin, row_buf);
+        for(unsigned int y = y_begin; y < y_end; ++y)
         {
-            regions.union_reps(set_1, set_2);
+            const int * next_row = y + 1 < grid.height() ? grid.region_row(y + 1, next_buf) : nullptr;
 
-            // destroy walls joining regions
-            grid[conn.cell_1.y][conn.cell_1.x].walls[conn.dir_1] = false;
-            grid[conn.cell_2.y][conn.cell_2.x].walls[conn.dir_2] = false;
+            std::size_t count = scan_connector_row(row, next_row, grid.width(),
+                (std::uint64_t)y * grid.width(), scratch.data());
+            connectors.insert(connectors.end(), scratch.begin(), scratch.begin() + count);
 
-            if(--num_sets == 1)
-                break;
+            // next_row's storage becomes row_buf, and the old row's is reused
+            row = next_row;
+            std::swap(row_buf, next_buf);
         }
-    }
-}
+    };
 
-void destroy_rand_walls(std::vector<std::vector<Grid_cell>> & grid,
-    const unsigned int wall_rm_attempts)
-{
-    //  randomly destroy random walls
-    for(unsigned int i = 0; i  < wall_rm_attempts; ++i)
-    {
-        sf::Vector2u cell(std::uniform_int_distribution<unsigned int>(0, grid[0].size() - 1)(prng),
-            std::uniform_int_distribution<unsigned int>(0, grid.size() - 1)(prng));
+    if(num_blocks == 1)
+        scan_block(0);
+    else
+        parallel_for(num_blocks, scan_block);
 
-        Direction wall = (Direction)std::uniform_int_distribution<int>(0, 3)(prng);
+    std::size_t total = 0;
+    for(const auto & connectors: block_connectors)
+        total += connectors.size();
 
-        switch(wall)
-        {
-        case UP:
-            if(cell.y > 0)
-            {
-                grid[cell.y][cell.x].walls[UP] = false;
-                grid[cell.y - 1][cell.x].walls[DOWN] = false;
-            }
-            break;
-        case DOWN:
-            if(cell.y < grid.size() - 1)
-            {
-                grid[cell.y][cell.x].walls[DOWN] = false;
-                grid[cell.y + 1][cell.x].walls[UP] = false;
-            }
-            break;
-        case LEFT:
-            if(cell.x > 0)
-            {
-                grid[cell.y][cell.x].walls[LEFT] = false;
-                grid[cell.y][cell.x - 1].walls[RIGHT] = false;
-            }
-            break;
-        case RIGHT:
-            if(cell.x < grid[0].size() - 1)
-            {
-                grid[cell.y][cell.x].walls[RIGHT] = false;
-                grid[cell.y][cell.x + 1].walls[LEFT] = false;
-            }
-            break;
-        }
+    std::vector<std::uint64_t> connectors;
+    connectors.reserve(total);
+    for(auto & block: block_connectors)
+    {
+        connectors.insert(connectors.end(), block.begin(), block.end());
+        std::vector<std::uint64_t>().swap(block);
     }
+
+    return connectors;
 }
 
-void Grid::gen_rooms(const Mazegen_alg mazegen,
-    const unsigned int room_attempts, const unsigned int wall_rm_attempts)
+void Gen_step::finish()
+{
+    std::size_t budget = unlimited;
+    while(!step(budget))
+        budget = unlimited;
+}
+
+Room_placer::Room_placer(Grid & grid, const unsigned int room_attempts, const int region):
+    _grid(grid), _attempts_left(room_attempts), _region(region)
+{}
+
+bool Room_placer::step(std::size_t & budget)
 {
-    int region = 0;
     // place some random rooms
-    for(unsigned int i = 0; i  < room_attempts; ++i)
+    for(; _attempts_left > 0 && budget > 0; --_attempts_left, --budget)
     {
         sf::Vector2u pos, size;
-        if(!attempt_gen_room(grid, pos, size))
+        if(!attempt_gen_room(_grid, _grid.prng(), pos, size))
             continue;
 
-        place_room(grid, pos, size, region++);
+        place_room(_grid, pos, size, _region++);
     }
 
-    // get mazegen function
-    std::function<void(Grid &, const sf::Vector2u &, const int)> mazegen_f;
+    return _attempts_left == 0;
+}
+
+int Room_placer::region() const
+{
+    return _region;
+}
+
+Maze_fill::Maze_fill(Grid & grid, const int region):
+    _grid(grid), _region(region)
+{}
+
+int Maze_fill::region() const
+{
+    return _region;
+}
+
+std::unique_ptr<Maze_fill> make_maze_fill(Grid & grid, const Grid::Mazegen_alg mazegen, const int region)
+{
+    // each growing tree policy is its own instantiation, so the generator's
+    // inner loop is specialized to it
     switch(mazegen)
     {
-    case MAZEGEN_DFS:
-        mazegen_f = &Grid::mazegen_dfs;
-        break;
-    case MAZEGEN_PRIM:
-        mazegen_f = &Grid::mazegen_kruskal;
-        break;
-    case MAZEGEN_KRUSKAL:
-        mazegen_f = &Grid::mazegen_kruskal;
-        break;
+    case Grid::MAZEGEN_DFS:
+        return std::unique_ptr<Maze_fill>(new Growing_tree_fill<Newest_cell>(grid, region));
+    case Grid::MAZEGEN_PRIM:
+        return std::unique_ptr<Maze_fill>(new Growing_tree_fill<Random_cell>(grid, region));
+    case Grid::MAZEGEN_GROWING_TREE:
+        return std::unique_ptr<Maze_fill>(new Growing_tree_fill<Mixed_cell<50>>(grid, region));
+    case Grid::MAZEGEN_KRUSKAL:
+        return std::unique_ptr<Maze_fill>(new Kruskal_fill(grid, region));
+    case Grid::MAZEGEN_DIVISION:
+        return std::unique_ptr<Maze_fill>(new Division_fill(grid, region));
     }
 
-    // fill in remaining areas with mazes
-    for(std::size_t row = 0; row < grid.size(); ++row)
+    throw std::invalid_argument("Unknown maze algorithm: " + std::to_string(mazegen));
+}
+
+Region_joiner::Region_joiner(Grid & grid, const int num_regions):
+    _grid(grid), _regions(num_regions), _num_sets(num_regions)
+{}
+
+bool Region_joiner::step(std::size_t & budget)
+{
+    if(!_found)
     {
-        for(std::size_t col = 0; col < grid[0].size(); ++col)
+        // find connectors (walls that separate 2 different regions), and
+        // shuffle them
+        _connectors = find_connectors(_grid);
+        std::shuffle(_connectors.begin(), _connectors.end(), _grid.prng());
+        _found = true;
+        budget -= std::min(budget, _connectors.size());
+    }
+
+    // use Kruskal's alg to find min spanning tree of region graph
+    for(; _next < _connectors.size() && _num_sets > 1 && budget > 0; ++_next, --budget)
+    {
+        std::uint64_t conn = _connectors[_next];
+        unsigned int x = (conn / 2) % _grid.width();
+        unsigned int y = (conn / 2) / _grid.width();
+        Direction dir = conn % 2 ? DOWN : RIGHT;
+
+        int region_1 = _grid.region(x, y);
+        int region_2 = dir == DOWN ? _grid.region(x, y + 1) : _grid.region(x + 1, y);
+
+        if(_regions.union_reps(region_1, region_2))
         {
-            if(!grid[row][col].visited)
-            {
-                mazegen_f(*this, sf::Vector2u(col, row), region++);
-            }
+            // destroy walls joining regions
+            _grid.set_wall(x, y, dir, false);
+            --_num_sets;
         }
     }
 
-    join_regions(grid, region);
+    if(_next < _connectors.size() && _num_sets > 1)
+        return false;
+
+    std::vector<std::uint64_t>().swap(_connectors);
+    return true;
+}
+
+Wall_remover::Wall_remover(Grid & grid, const unsigned int wall_rm_attempts):
+    _grid(grid), _attempts_left(wall_rm_attempts)
+{}
+
+bool Wall_remover::step(std::size_t & budget)
+{
+    //  randomly destroy random walls
+    for(; _attempts_left > 0 && budget > 0; --_attempts_left, --budget)
+    {
+        sf::Vector2u cell(std::uniform_int_distribution<unsigned int>(0, _grid.width() - 1)(_grid.prng()),
+            std::uniform_int_distribution<unsigned int>(0, _grid.height() - 1)(_grid.prng()));
+
+        Direction wall = (Direction)std::uniform_int_distribution<int>(0, 3)(_grid.prng());
+
+        // border walls are left untouched by set_wall
+        _grid.set_wall(cell.x, cell.y, wall, false);
+    }
+
+    return _attempts_left == 0;
+}
 
-    // destroy some walls to create multiple paths between cells
-    destroy_rand_walls(grid, wall_rm_attempts);
+int Grid::place_rooms(const unsigned int room_attempts, int region)
+{
+    Room_placer placer(*this, room_attempts, region);
+    placer.finish();
+    return placer.region();
+}
+
+int Grid::fill_mazes(const Mazegen_alg mazegen, int region)
+{
+    std::unique_ptr<Maze_fill> fill = make_maze_fill(*this, mazegen, region);
+    fill->finish();
+    return fill->region();
+}
+
+void Grid::join_regions(const int num_regions)
+{
+    Region_joiner(*this, num_regions).finish();
+}
+
+void Grid::destroy_rand_walls(const unsigned int wall_rm_attempts)
+{
+    Wall_remover(*this, wall_rm_attempts).finish();
+}
+
+void Grid::gen_rooms(const Mazegen_alg mazegen,
+    const unsigned int room_attempts, const unsigned int wall_rm_attempts)
+{
+    Maze_builder(*this, mazegen, room_attempts, wall_rm_attempts).finish();
 }
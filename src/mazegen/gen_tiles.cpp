@@ -0,0 +1,161 @@
+// gen_tiles.cpp
+// parallel tiled maze generation
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mazegen/grid.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "util/parallel.hpp"
+
+int Grid::fill_mazes_tiled(const Mazegen_alg mazegen, int region,
+    const unsigned int tile_size, const unsigned int num_threads)
+{
+    if(tile_size == 0 || tile_size % Bit_plane::word_bits != 0)
+    {
+        throw std::invalid_argument("tile_size must be a multiple of " + std::to_string(Bit_plane::word_bits));
+    }
+
+    unsigned int tiles_x = (_width + tile_size - 1) / tile_size;
+    unsigned int tiles_y = (_height + tile_size - 1) / tile_size;
+    std::size_t num_tiles = (std::size_t)tiles_x * tiles_y;
+
+    // each tile gets its own RNG substream, numbered by tile, so the maze
+    // doesn't depend on the number of threads
+    std::uint64_t tiles_seed = _prng();
+
+    // Tasks must not share bit plane words. Tiles are a multiple of 64 cells
+    // on a side, so in Z-order, or in row-major when rows are whole words,
+    // every tile is word aligned. Otherwise a task takes a whole row of tiles
+    std::size_t tiles_per_task = (_layout == LAYOUT_Z_ORDER || _width % Bit_plane::word_bits == 0) ? 1 : tiles_x;
+    std::size_t num_tasks = num_tiles / tiles_per_task;
+
+    auto tile_rect = [this, tile_size, tiles_x](const std::size_t tile, sf::Vector2u & origin, sf::Vector2u & size)
+    {
+        origin = sf::Vector2u((tile % tiles_x) * tile_size, (tile / tiles_x) * tile_size);
+        size = sf::Vector2u(std::min(tile_size, _width - origin.x), std::min(tile_size, _height - origin.y));
+    };
+
+    std::vector<int> tile_regions(num_tiles);
+
+    // copy a tile's new cells back. Region ids aren't known until every tile
+    // is done, so store the tile-local id as -2 - id for now
+    auto copy_back = [this](const Grid & tile_grid, const sf::Vector2u & origin, const sf::Vector2u & size)
+    {
+        for(unsigned int row = 0; row < size.y; ++row)
+        {
+            for(unsigned int col = 0; col < size.x; ++col)
+            {
+                unsigned int x = origin.x + col, y = origin.y + row;
+                if(visited(x, y))
+                    continue;
+
+                set_visited(x, y, true);
+                set_region(x, y, -2 - tile_grid.region(col, row));
+
+                // walls along tile edges are left for join_regions
+                if(col < size.x - 1 && !tile_grid.wall(col, row, RIGHT))
+                    set_wall(x, y, RIGHT, false);
+                if(row < size.y - 1 && !tile_grid.wall(col, row, DOWN))
+                    set_wall(x, y, DOWN, false);
+            }
+        }
+    };
+
+    // the region map can't widen while tasks are writing to it, so tiles
+    // with too many regions to fit are kept & copied back afterwards
+    std::vector<std::unique_ptr<Grid>> deferred(num_tiles);
+
+    parallel_for(num_tasks, [&](const std::size_t task)
+    {
+        for(std::size_t tile = task * tiles_per_task; tile < (task + 1) * tiles_per_task; ++tile)
+        {
+            sf::Vector2u origin, size;
+            tile_rect(tile, origin, size);
+
+            std::unique_ptr<Grid> tile_grid(new Grid(size.x, size.y, substream_seed(tiles_seed, tile)));
+
+            // already filled cells (rooms) are off-limits
+            for(unsigned int row = 0; row < size.y; ++row)
+            {
+                for(unsigned int col = 0; col < size.x; ++col)
+                {
+                    if(visited(origin.x + col, origin.y + row))
+                        tile_grid->set_visited(col, row, true);
+                }
+            }
+
+            tile_regions[tile] = tile_grid->fill_mazes(mazegen, 0);
+
+            if(_region.fits(-1 - tile_regions[tile]))
+                copy_back(*tile_grid, origin, size);
+            else
+                deferred[tile] = std::move(tile_grid);
+        }
+    }, num_threads);
+
+    for(std::size_t tile = 0; tile < num_tiles; ++tile)
+    {
+        if(!deferred[tile])
+            continue;
+
+        sf::Vector2u origin, size;
+        tile_rect(tile, origin, size);
+        _region.reserve(-1 - tile_regions[tile], -1);
+        copy_back(*deferred[tile], origin, size);
+        deferred[tile].reset();
+    }
+
+    // assign each tile a contiguous block of region ids
+    std::vector<int> tile_base(num_tiles);
+    for(std::size_t tile = 0; tile < num_tiles; ++tile)
+    {
+        tile_base[tile] = region;
+        region += tile_regions[tile];
+    }
+
+    _region.reserve(0, region - 1);
+
+    parallel_for(num_tasks, [&](const std::size_t task)
+    {
+        for(std::size_t tile = task * tiles_per_task; tile < (task + 1) * tiles_per_task; ++tile)
+        {
+            sf::Vector2u origin, size;
+            tile_rect(tile, origin, size);
+
+            for(unsigned int y = origin.y; y < origin.y + size.y; ++y)
+            {
+                for(unsigned int x = origin.x; x < origin.x + size.x; ++x)
+                {
+                    int local_region = this->region(x, y);
+                    if(local_region <= -2)
+                        set_region(x, y, tile_base[tile] - 2 - local_region);
+                }
+            }
+        }
+    }, num_threads);
+
+    return region;
+}
@@ -23,21 +23,54 @@
 
 #include "mazegen/grid.hpp"
 
+#include <algorithm>
 #include <stdexcept>
+#include <string>
 
+#include "mazegen/maze_row.hpp"
 #include "util/logger.hpp"
 
-Grid_cell::Grid_cell(): visited(false), region(-1), room(false)
+namespace
 {
-    for(int i = 0; i < 4; ++i)
-        walls[i] = true;
+    // masks over a Z-order tile word, of the cells with local x (or y) below i
+    struct Tile_masks
+    {
+        Tile_masks()
+        {
+            for(unsigned int i = 0; i <= 8; ++i)
+            {
+                x_below[i] = y_below[i] = 0;
+                for(unsigned int bit = 0; bit < 64; ++bit)
+                {
+                    // x is in the even bits, y in the odd
+                    unsigned int x = (bit & 1) | ((bit >> 1) & 2) | ((bit >> 2) & 4);
+                    unsigned int y = ((bit >> 1) & 1) | ((bit >> 2) & 2) | ((bit >> 3) & 4);
+                    if(x < i)
+                        x_below[i] |= (Bit_plane::Word)1 << bit;
+                    if(y < i)
+                        y_below[i] |= (Bit_plane::Word)1 << bit;
+                }
+            }
+        }
+
+        Bit_plane::Word x_below[9];
+        Bit_plane::Word y_below[9];
+    };
+
+    const Tile_masks tile_masks;
 }
 
-Grid::Grid(const unsigned int width, const unsigned int height,
-    const Mazegen_alg mazegen, const unsigned int room_attempts, const unsigned int wall_rm_attempts)
-{
-    Logger_locator::get()(Logger::TRACE, "Generating maze grid...");
+const unsigned int Grid::_tile_shift;
+const unsigned int Grid::_tile_size;
 
+Grid::Grid(const unsigned int width, const unsigned int height, const std::uint64_t seed,
+    const Layout layout):
+    _width(width), _height(height),
+    _tiles_x((width + _tile_size - 1) / _tile_size),
+    _layout(layout),
+    _seed(seed),
+    _prng(seed)
+{
     if(height == 0)
     {
         throw std::invalid_argument("grid_size.y == 0");
@@ -47,7 +80,111 @@ Grid::Grid(const unsigned int width, const unsigned int height,
         throw std::invalid_argument("grid_size.x == 0");
     }
 
-    grid.assign(height, std::vector<Grid_cell>(width));
+    // Z-order storage is padded out to whole tiles
+    std::size_t storage_size;
+    if(_layout == LAYOUT_Z_ORDER)
+    {
+        unsigned int tiles_y = (height + _tile_size - 1) / _tile_size;
+        storage_size = (std::size_t)_tiles_x * tiles_y * _tile_size * _tile_size;
+    }
+    else
+        storage_size = (std::size_t)width * height;
+
+    _right_walls.assign(storage_size, true);
+    _down_walls.assign(storage_size, true);
+    _visited.assign(storage_size, false);
+    _room.assign(storage_size, false);
+    _region.assign(storage_size, -1);
+}
+
+Grid::Grid(const unsigned int width, const unsigned int height,
+    const Mazegen_alg mazegen, const unsigned int room_attempts, const unsigned int wall_rm_attempts,
+    const std::uint64_t seed, const Layout layout):
+    Grid(width, height, seed, layout)
+{
+    Logger_locator::get()(Logger::TRACE, "Generating maze grid, seed: " + std::to_string(seed));
 
     gen_rooms(mazegen, room_attempts, wall_rm_attempts);
 }
+
+void Grid::open_sides(std::vector<std::uint8_t> & sides) const
+{
+    sides.assign((std::size_t)_width * _height, 0);
+
+    // each interior wall is read once, and opens a side of both its cells
+    for(unsigned int y = 0; y < _height; ++y)
+    {
+        for(unsigned int x = 0; x < _width; ++x)
+        {
+            std::size_t cell = (std::size_t)y * _width + x;
+            if(x < _width - 1 && !_right_walls.get(index(x, y)))
+            {
+                sides[cell] |= 1 << RIGHT;
+                sides[cell + 1] |= 1 << LEFT;
+            }
+            if(y < _height - 1 && !_down_walls.get(index(x, y)))
+            {
+                sides[cell] |= 1 << DOWN;
+                sides[cell + _width] |= 1 << UP;
+            }
+        }
+    }
+}
+
+void Grid::set_row(const unsigned int y, const Maze_row & row, const int region)
+{
+    if(_layout == LAYOUT_ROW_MAJOR)
+    {
+        std::size_t begin = index(0, y);
+        _right_walls.copy_in(begin, row.right.data(), _width);
+        _down_walls.copy_in(begin, row.down.data(), _width);
+        _visited.fill(begin, begin + _width, true);
+        _region.fill(begin, begin + _width, region);
+        return;
+    }
+
+    for(unsigned int x = 0; x < _width; ++x)
+    {
+        set_visited(x, y, true);
+        set_region(x, y, region);
+        set_wall(x, y, RIGHT, row.right.get(x));
+        set_wall(x, y, DOWN, row.down.get(x));
+    }
+}
+
+bool Grid::any_visited(const unsigned int x0, const unsigned int y0,
+    const unsigned int x1, const unsigned int y1) const
+{
+    if(x0 >= x1 || y0 >= y1)
+        return false;
+
+    if(_layout == LAYOUT_ROW_MAJOR)
+    {
+        for(unsigned int y = y0; y < y1; ++y)
+        {
+            if(_visited.any(index(x0, y), index(x0, y) + (x1 - x0)))
+                return true;
+        }
+        return false;
+    }
+
+    // each tile is one word. mask off the part of the rect inside it
+    static_assert(_tile_shift == 3, "tile_masks assumes 8x8 tiles");
+    for(unsigned int tile_y = y0 >> _tile_shift; tile_y <= (y1 - 1) >> _tile_shift; ++tile_y)
+    {
+        unsigned int base_y = tile_y << _tile_shift;
+        Bit_plane::Word y_mask = tile_masks.y_below[std::min(y1 - base_y, _tile_size)] &
+            ~tile_masks.y_below[std::max(y0, base_y) - base_y];
+
+        for(unsigned int tile_x = x0 >> _tile_shift; tile_x <= (x1 - 1) >> _tile_shift; ++tile_x)
+        {
+            unsigned int base_x = tile_x << _tile_shift;
+            Bit_plane::Word x_mask = tile_masks.x_below[std::min(x1 - base_x, _tile_size)] &
+                ~tile_masks.x_below[std::max(x0, base_x) - base_x];
+
+            if(_visited.data()[(std::size_t)tile_y * _tiles_x + tile_x] & x_mask & y_mask)
+                return true;
+        }
+    }
+    return false;
+}
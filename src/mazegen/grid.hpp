@@ -24,44 +24,257 @@
 #ifndef GRID_HPP
 #define GRID_HPP
 
+#include <cstdint>
+#include <vector>
+
 #include <SFML/System.hpp>
 
-enum Direction {UP = 0, DOWN, LEFT, RIGHT};
+#include "mazegen/bit_plane.hpp"
+#include "mazegen/region_map.hpp"
+#include "mazegen/rng.hpp"
 
-class Grid_cell
-{
-public:
-    Grid_cell();
-    bool walls[4];
-    bool visited;
-    int region;
-    bool room;
-};
+enum Direction {UP = 0, DOWN, LEFT, RIGHT};
 
-struct Wall
-{
-    sf::Vector2u cell_1, cell_2;
-    Direction dir_1, dir_2;
-    int region_1, region_2;
-};
+struct Maze_row;
 
 class Grid final
 {
 public:
-    typedef enum {MAZEGEN_DFS, MAZEGEN_PRIM, MAZEGEN_KRUSKAL} Mazegen_alg;
+    // MAZEGEN_GROWING_TREE picks the newest cell half the time, and a random
+    // one otherwise (see growing_tree.hpp). MAZEGEN_DIVISION is recursive
+    // division, with long straight walls
+    typedef enum {MAZEGEN_DFS, MAZEGEN_PRIM, MAZEGEN_KRUSKAL, MAZEGEN_GROWING_TREE,
+        MAZEGEN_DIVISION} Mazegen_alg;
 
+    // cell storage order. Z_ORDER stores cells in 8x8 tiles, Morton ordered
+    // within each tile, so that neighboring cells share cache lines
+    typedef enum {LAYOUT_ROW_MAJOR, LAYOUT_Z_ORDER} Layout;
+
+    // create an empty grid: all walls up, no cells visited. All generation
+    // phases draw from an engine seeded with seed, so the same seed and
+    // phases always give the same maze
+    Grid(const unsigned int width, const unsigned int height,
+        const std::uint64_t seed,
+        const Layout layout = LAYOUT_ROW_MAJOR);
+
+    // create and generate a maze
     Grid(const unsigned int width, const unsigned int height,
         const Mazegen_alg mazegen,
-        const unsigned int room_attempts, const unsigned int wall_rm_attempts);
+        const unsigned int room_attempts, const unsigned int wall_rm_attempts,
+        const std::uint64_t seed,
+        const Layout layout = LAYOUT_ROW_MAJOR);
+
+    // generation phases, in the order the generating constructor runs them,
+    // each run to completion. place_rooms & fill_mazes return the next unused
+    // region id. See Maze_builder to run them a slice at a time
+    int place_rooms(const unsigned int room_attempts, int region = 0);
+    int fill_mazes(const Mazegen_alg mazegen, int region);
+    // same as fill_mazes, but splits the grid into tile_size x tile_size tiles
+    // (tile_size a multiple of 64), generated concurrently with num_threads
+    // workers (0 for hardware concurrency). Each tile is at least one region,
+    // to be connected by join_regions. Each tile has its own RNG substream, so
+    // the result doesn't depend on num_threads
+    int fill_mazes_tiled(const Mazegen_alg mazegen, int region,
+        const unsigned int tile_size = 256, const unsigned int num_threads = 0);
+    void join_regions(const int num_regions);
+    void destroy_rand_walls(const unsigned int wall_rm_attempts);
+
+    unsigned int width() const;
+    unsigned int height() const;
+    Layout layout() const;
+    std::uint64_t seed() const;
+    // the engine all generation phases draw from
+    Mazegen_rng & prng();
+
+    // storage index of a cell
+    std::size_t index(const unsigned int x, const unsigned int y) const;
 
-    std::vector<std::vector<Grid_cell>> grid;
+    // each wall is shared by 2 cells, but only stored once, as the RIGHT or
+    // DOWN wall of the upper / left cell. Border walls are always present
+    bool wall(const unsigned int x, const unsigned int y, const Direction dir) const;
+    void set_wall(const unsigned int x, const unsigned int y, const Direction dir, const bool val);
+    // one byte per cell, in row-major order whatever the layout, with bit
+    // (1 << Direction) set for each side without a wall. For searches that
+    // step between cells far more often than the walls change
+    void open_sides(std::vector<std::uint8_t> & sides) const;
+    // write all of row y: its walls from row, and every cell visited & in
+    // region. Whole words at a time in row-major layout
+    void set_row(const unsigned int y, const Maze_row & row, const int region);
+
+    bool visited(const unsigned int x, const unsigned int y) const;
+    // true if any cell in [x0, x1) x [y0, y1) is visited. Tests whole words
+    // at a time, so small rectangles cost a handful of reads
+    bool any_visited(const unsigned int x0, const unsigned int y0,
+        const unsigned int x1, const unsigned int y1) const;
+    void set_visited(const unsigned int x, const unsigned int y, const bool val);
+
+    int region(const unsigned int x, const unsigned int y) const;
+    void set_region(const unsigned int x, const unsigned int y, const int region);
+    // regions of row y, left to right. Points into the grid when rows are
+    // contiguous (row-major) & ids are held as ints, otherwise the row is
+    // copied into buf
+    const int * region_row(const unsigned int y, std::vector<int> & buf) const;
+    // free the region ids of a finished maze that won't be given to a
+    // Region_pathfinder. No region accessors or generation phases may be
+    // called afterwards
+    void drop_regions();
+    bool has_regions() const;
+
+    bool room(const unsigned int x, const unsigned int y) const;
+    void set_room(const unsigned int x, const unsigned int y, const bool val);
 
 private:
     void gen_rooms(const Mazegen_alg mazegen,
         const unsigned int room_attempts, const unsigned int wall_rm_attempts);
-    void mazegen_dfs(const sf::Vector2u & start, const int region);
-    void mazegen_prim(const sf::Vector2u & start, const int region);
-    void mazegen_kruskal(const sf::Vector2u & start, const int region);
+    // fills all unvisited cells at once. Run through Division_fill
+    int fill_mazes_division(int region);
+    friend class Division_fill;
+
+    static const unsigned int _tile_shift = 3;
+    static const unsigned int _tile_size = 1 << _tile_shift;
+
+    unsigned int _width, _height;
+    unsigned int _tiles_x;
+    Layout _layout;
+
+    std::uint64_t _seed;
+    Mazegen_rng _prng;
+
+    Bit_plane _right_walls;
+    Bit_plane _down_walls;
+    Bit_plane _visited;
+    Bit_plane _room;
+    Region_map _region;
 };
 
+inline unsigned int Grid::width() const
+{
+    return _width;
+}
+
+inline unsigned int Grid::height() const
+{
+    return _height;
+}
+
+inline Grid::Layout Grid::layout() const
+{
+    return _layout;
+}
+
+inline std::uint64_t Grid::seed() const
+{
+    return _seed;
+}
+
+inline Mazegen_rng & Grid::prng()
+{
+    return _prng;
+}
+
+inline std::size_t Grid::index(const unsigned int x, const unsigned int y) const
+{
+    if(_layout == LAYOUT_ROW_MAJOR)
+        return (std::size_t)y * _width + x;
+
+    // interleave the low 3 bits of x & y
+    auto spread = [](const unsigned int v) -> std::size_t
+    {
+        return (v & 1) | ((v & 2) << 1) | ((v & 4) << 2);
+    };
+
+    std::size_t tile = (std::size_t)(y >> _tile_shift) * _tiles_x + (x >> _tile_shift);
+    return (tile << (2 * _tile_shift)) | spread(x) | (spread(y) << 1);
+}
+
+inline bool Grid::wall(const unsigned int x, const unsigned int y, const Direction dir) const
+{
+    switch(dir)
+    {
+    case UP:
+        return y == 0 || _down_walls.get(index(x, y - 1));
+    case DOWN:
+        return y == _height - 1 || _down_walls.get(index(x, y));
+    case LEFT:
+        return x == 0 || _right_walls.get(index(x - 1, y));
+    case RIGHT:
+        return x == _width - 1 || _right_walls.get(index(x, y));
+    }
+    return true;
+}
+
+inline void Grid::set_wall(const unsigned int x, const unsigned int y, const Direction dir, const bool val)
+{
+    switch(dir)
+    {
+    case UP:
+        if(y > 0)
+            _down_walls.set(index(x, y - 1), val);
+        break;
+    case DOWN:
+        if(y < _height - 1)
+            _down_walls.set(index(x, y), val);
+        break;
+    case LEFT:
+        if(x > 0)
+            _right_walls.set(index(x - 1, y), val);
+        break;
+    case RIGHT:
+        if(x < _width - 1)
+            _right_walls.set(index(x, y), val);
+        break;
+    }
+}
+
+inline bool Grid::visited(const unsigned int x, const unsigned int y) const
+{
+    return _visited.get(index(x, y));
+}
+
+inline void Grid::set_visited(const unsigned int x, const unsigned int y, const bool val)
+{
+    _visited.set(index(x, y), val);
+}
+
+inline int Grid::region(const unsigned int x, const unsigned int y) const
+{
+    return _region.get(index(x, y));
+}
+
+inline const int * Grid::region_row(const unsigned int y, std::vector<int> & buf) const
+{
+    if(_layout == LAYOUT_ROW_MAJOR && _region.wide_data())
+        return _region.wide_data() + index(0, y);
+
+    buf.resize(_width);
+    for(unsigned int x = 0; x < _width; ++x)
+        buf[x] = _region.get(index(x, y));
+    return buf.data();
+}
+
+inline void Grid::drop_regions()
+{
+    _region.clear();
+}
+
+inline bool Grid::has_regions() const
+{
+    return !_region.empty();
+}
+
+inline void Grid::set_region(const unsigned int x, const unsigned int y, const int region)
+{
+    _region.set(index(x, y), region);
+}
+
+inline bool Grid::room(const unsigned int x, const unsigned int y) const
+{
+    return _room.get(index(x, y));
+}
+
+inline void Grid::set_room(const unsigned int x, const unsigned int y, const bool val)
+{
+    _room.set(index(x, y), val);
+}
+
 #endif // GRID_HPP
@@ -0,0 +1,211 @@
+// growing_tree.hpp
+// growing tree maze generation, specialized by cell selection policy
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef GROWING_TREE_HPP
+#define GROWING_TREE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include "mazegen/grid.hpp"
+#include "mazegen/maze_builder.hpp"
+
+// Cell selection policies for Growing_tree_fill. Each picks which of
+// the size active cells to grow from next. keeps_order is true if the policy
+// depends on the order cells became active, so they can't be removed by
+// swapping in the last one
+
+// always the newest cell: depth first search
+struct Newest_cell
+{
+    static const bool keeps_order = false;
+    std::size_t operator()(const std::size_t size, Mazegen_rng &) const
+    {
+        return size - 1;
+    }
+};
+
+// a random cell: simplified Prim's algorithm
+struct Random_cell
+{
+    static const bool keeps_order = false;
+    std::size_t operator()(const std::size_t size, Mazegen_rng & prng) const
+    {
+        return std::uniform_int_distribution<std::size_t>(0, size - 1)(prng);
+    }
+};
+
+// the newest cell newest_percent% of the time, otherwise a random one. Long
+// corridors like DFS, with more branching the lower newest_percent is
+template<unsigned int newest_percent>
+struct Mixed_cell
+{
+    static const bool keeps_order = true;
+    std::size_t operator()(const std::size_t size, Mazegen_rng & prng) const
+    {
+        if(prng() % 100 < newest_percent)
+            return size - 1;
+        return std::uniform_int_distribution<std::size_t>(0, size - 1)(prng);
+    }
+};
+
+// Keeps a list of active cells, each with its directions in shuffled order.
+// Each step, the selected cell tries its next direction, and carves into the
+// neighbor there if unvisited, making it active. A cell with no directions
+// left is removed when next selected: by swapping in the last cell, or if the
+// policy keeps_order, by leaving it in place until spent cells are over half
+// the list, then removing them all at once. When the list runs out, the next
+// unvisited cell in row-major order starts a new tree & region
+template<typename Select_cell>
+class Growing_tree_fill final: public Maze_fill
+{
+public:
+    Growing_tree_fill(Grid & grid, const int region);
+    bool step(std::size_t & budget);
+
+private:
+    struct State
+    {
+        sf::Vector2u pos;
+        Direction dirs[4];
+        unsigned short dir_i;
+    };
+
+    void activate(const sf::Vector2u & pos);
+
+    std::vector<State> _active;
+    std::size_t _num_spent = 0; // active cells with no directions left
+    Select_cell _select;
+    sf::Vector2u _scan; // where to look for the next unvisited cell
+};
+
+template<typename Select_cell>
+Growing_tree_fill<Select_cell>::Growing_tree_fill(Grid & grid, const int region):
+    Maze_fill(grid, region), _scan(0, 0)
+{}
+
+template<typename Select_cell>
+void Growing_tree_fill<Select_cell>::activate(const sf::Vector2u & pos)
+{
+    _grid.set_visited(pos.x, pos.y, true);
+    _grid.set_region(pos.x, pos.y, _region);
+    _active.push_back({pos, {UP, DOWN, LEFT, RIGHT}, 0});
+    std::shuffle(std::begin(_active.back().dirs), std::end(_active.back().dirs), _grid.prng());
+}
+
+template<typename Select_cell>
+bool Growing_tree_fill<Select_cell>::step(std::size_t & budget)
+{
+    Mazegen_rng & prng = _grid.prng();
+    unsigned int width = _grid.width(), height = _grid.height();
+
+    while(budget > 0)
+    {
+        --budget;
+
+        if(_active.empty())
+        {
+            // the last tree is done, start the next at the next unvisited cell
+            for(; _scan.y < height; ++_scan.y, _scan.x = 0)
+            {
+                for(; _scan.x < width && _grid.visited(_scan.x, _scan.y); ++_scan.x);
+                if(_scan.x < width)
+                    break;
+            }
+            if(_scan.y == height)
+                return true;
+
+            activate(_scan);
+            continue;
+        }
+
+        std::size_t i = _select(_active.size(), prng);
+        State & state = _active[i];
+        if(state.dir_i >= 4)
+        {
+            if(i == _active.size() - 1)
+            {
+                _active.pop_back();
+                --_num_spent;
+                if(_active.empty())
+                    ++_region;
+            }
+            else if(!Select_cell::keeps_order)
+            {
+                state = _active.back();
+                _active.pop_back();
+                --_num_spent;
+            }
+            else if(_num_spent * 2 > _active.size())
+            {
+                _active.erase(std::remove_if(_active.begin(), _active.end(),
+                    [](const State & s){ return s.dir_i >= 4; }), _active.end());
+                _num_spent = 0;
+                if(_active.empty())
+                    ++_region;
+            }
+            continue;
+        }
+
+        Direction dir = state.dirs[state.dir_i++];
+        if(state.dir_i == 4)
+            ++_num_spent;
+        sf::Vector2u next = state.pos;
+        switch(dir)
+        {
+        case UP:
+            if(next.y == 0)
+                continue;
+            --next.y;
+            break;
+        case DOWN:
+            if(next.y == height - 1)
+                continue;
+            ++next.y;
+            break;
+        case LEFT:
+            if(next.x == 0)
+                continue;
+            --next.x;
+            break;
+        case RIGHT:
+            if(next.x == width - 1)
+                continue;
+            ++next.x;
+            break;
+        }
+
+        if(!_grid.visited(next.x, next.y))
+        {
+            _grid.set_wall(state.pos.x, state.pos.y, dir, false);
+            activate(next);
+        }
+    }
+
+    return false;
+}
+
+#endif // GROWING_TREE_HPP
@@ -0,0 +1,82 @@
+// maze_builder.cpp
+// resumable maze generation, a slice of work at a time
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mazegen/maze_builder.hpp"
+
+Maze_builder::Maze_builder(Grid & grid, const Grid::Mazegen_alg mazegen,
+    const unsigned int room_attempts, const unsigned int wall_rm_attempts):
+    _grid(grid), _mazegen(mazegen), _wall_rm_attempts(wall_rm_attempts),
+    _step(new Room_placer(grid, room_attempts, 0))
+{}
+
+bool Maze_builder::step(std::size_t budget)
+{
+    while(_phase != PHASE_DONE && budget > 0)
+    {
+        if(_step->step(budget))
+            next_phase();
+    }
+
+    return _phase == PHASE_DONE;
+}
+
+bool Maze_builder::step_for(const std::chrono::steady_clock::duration & time,
+    const std::size_t check_interval)
+{
+    auto end = std::chrono::steady_clock::now() + time;
+    while(!step(check_interval) && std::chrono::steady_clock::now() < end);
+
+    return _phase == PHASE_DONE;
+}
+
+void Maze_builder::finish()
+{
+    step(Gen_step::unlimited);
+}
+
+void Maze_builder::next_phase()
+{
+    switch(_phase)
+    {
+    case PHASE_ROOMS:
+        _region = static_cast<Room_placer &>(*_step).region();
+        _step = make_maze_fill(_grid, _mazegen, _region);
+        _phase = PHASE_MAZES;
+        break;
+    case PHASE_MAZES:
+        _region = static_cast<Maze_fill &>(*_step).region();
+        _step.reset(new Region_joiner(_grid, _region));
+        _phase = PHASE_JOIN;
+        break;
+    case PHASE_JOIN:
+        // destroy some walls to create multiple paths between cells
+        _step.reset(new Wall_remover(_grid, _wall_rm_attempts));
+        _phase = PHASE_WALL_RM;
+        break;
+    case PHASE_WALL_RM:
+    case PHASE_DONE:
+        _step.reset();
+        _phase = PHASE_DONE;
+        break;
+    }
+}
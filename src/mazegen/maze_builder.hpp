@@ -0,0 +1,206 @@
+// maze_builder.hpp
+// resumable maze generation, a slice of work at a time
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef MAZE_BUILDER_HPP
+#define MAZE_BUILDER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "mazegen/disjoint_set.hpp"
+#include "mazegen/grid.hpp"
+#include "mazegen/rng.hpp"
+
+// A generation phase that keeps its state (stacks, frontiers, positions)
+// between calls, so it can be run a slice at a time. Each unit of budget is
+// about one cell or wall considered. Phases draw from the grid's engine in the
+// same order however they're sliced, so the maze only depends on the seed
+class Gen_step
+{
+public:
+    static const std::size_t unlimited = std::numeric_limits<std::size_t>::max();
+
+    virtual ~Gen_step() = default;
+
+    // do up to about budget units of work, subtracting what was done from
+    // budget. Returns true once the phase is finished
+    virtual bool step(std::size_t & budget) = 0;
+
+    // run to completion
+    void finish();
+};
+
+// tries to place room_attempts rooms, one per unit
+class Room_placer final: public Gen_step
+{
+public:
+    Room_placer(Grid & grid, const unsigned int room_attempts, const int region);
+    bool step(std::size_t & budget);
+    // next unused region id
+    int region() const;
+
+private:
+    Grid & _grid;
+    unsigned int _attempts_left;
+    int _region;
+};
+
+// fills every unvisited cell with maze. Each connected area of unvisited cells
+// gets at least one region
+class Maze_fill: public Gen_step
+{
+public:
+    // next unused region id. Only final once step has returned true
+    int region() const;
+
+protected:
+    Maze_fill(Grid & grid, const int region);
+
+    Grid & _grid;
+    int _region;
+};
+
+// the fill for mazegen, starting at region
+std::unique_ptr<Maze_fill> make_maze_fill(Grid & grid, const Grid::Mazegen_alg mazegen, const int region);
+
+// Kruskal's algorithm over every unvisited cell at once. Edges are IDs,
+// (y * width + x) * 2 for the wall right of (x, y), + 1 for the wall below it,
+// visited in a computed random order, so no list of walls is ever stored.
+// Walls between unvisited cells are knocked down wherever they join 2 sets, so
+// each connected area of unvisited cells becomes its own tree & region.
+// Regions are numbered in row-major order of each area's first cell
+class Kruskal_fill final: public Maze_fill
+{
+public:
+    Kruskal_fill(Grid & grid, const int region);
+    bool step(std::size_t & budget);
+
+private:
+    typedef enum {STAGE_EDGES, STAGE_CLEAR, STAGE_LABEL, STAGE_DONE} Stage;
+
+    Stage _stage = STAGE_EDGES;
+    Index_disjoint_set _cell_set; // by row-major index
+    Index_permutation _edges;
+    std::uint64_t _next_edge = 0;
+    unsigned int _row = 0; // next row to clear or label
+};
+
+// recursive division. Runs all at once on the first step, in parallel, so
+// it's sliced no finer than that
+class Division_fill final: public Maze_fill
+{
+public:
+    Division_fill(Grid & grid, const int region);
+    bool step(std::size_t & budget);
+};
+
+// connects all regions with a random spanning tree of connectors (walls
+// between 2 regions). Finding & shuffling the connectors is done all at once
+// on the first step, and costs a unit per connector. After that, it's a unit
+// per connector tried
+class Region_joiner final: public Gen_step
+{
+public:
+    Region_joiner(Grid & grid, const int num_regions);
+    bool step(std::size_t & budget);
+
+private:
+    Grid & _grid;
+    Index_disjoint_set _regions;
+    int _num_sets;
+    bool _found = false;
+    std::vector<std::uint64_t> _connectors;
+    std::size_t _next = 0;
+};
+
+// knocks down wall_rm_attempts random walls, one per unit
+class Wall_remover final: public Gen_step
+{
+public:
+    Wall_remover(Grid & grid, const unsigned int wall_rm_attempts);
+    bool step(std::size_t & budget);
+
+private:
+    Grid & _grid;
+    unsigned int _attempts_left;
+};
+
+// Runs all of Grid's generation phases on an empty grid, a slice at a time,
+// so generation can be spread over several frames. Gives the same maze as the
+// generating Grid constructor. The grid is only complete once step returns
+// true, but can be read (to show progress) between steps. The grid must
+// outlive the builder
+class Maze_builder final
+{
+public:
+    typedef enum {PHASE_ROOMS, PHASE_MAZES, PHASE_JOIN, PHASE_WALL_RM, PHASE_DONE} Phase;
+
+    Maze_builder(Grid & grid, const Grid::Mazegen_alg mazegen,
+        const unsigned int room_attempts, const unsigned int wall_rm_attempts);
+
+    // do up to about budget units of work (see Gen_step). Returns true once
+    // the maze is finished
+    bool step(std::size_t budget);
+    // step until finished or time is up. The clock is checked every
+    // check_interval units, so this can run over by that much work
+    bool step_for(const std::chrono::steady_clock::duration & time,
+        const std::size_t check_interval = 4096);
+    void finish();
+
+    Phase phase() const;
+    bool done() const;
+    Grid & grid();
+
+private:
+    // start the next phase
+    void next_phase();
+
+    Grid & _grid;
+    Grid::Mazegen_alg _mazegen;
+    unsigned int _wall_rm_attempts;
+
+    Phase _phase = PHASE_ROOMS;
+    std::unique_ptr<Gen_step> _step;
+    int _region = 0; // next unused region id, as of the last phase finished
+};
+
+inline Maze_builder::Phase Maze_builder::phase() const
+{
+    return _phase;
+}
+
+inline bool Maze_builder::done() const
+{
+    return _phase == PHASE_DONE;
+}
+
+inline Grid & Maze_builder::grid()
+{
+    return _grid;
+}
+
+#endif // MAZE_BUILDER_HPP
@@ -0,0 +1,65 @@
+// maze_chunk.cpp
+// piece of an endless maze, generated independently of its neighbors
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mazegen/maze_chunk.hpp"
+
+#include <random>
+
+#include "mazegen/rng.hpp"
+
+namespace
+{
+    // stream number for chunk (x, y). stream = 0 is the chunk's own maze, and
+    // 1 & 2 are its top & left edges
+    std::uint64_t chunk_stream(const int x, const int y, const std::uint64_t stream)
+    {
+        std::uint64_t coords = ((std::uint64_t)(std::uint32_t)x << 32) | (std::uint32_t)y;
+        return coords * 3 + stream;
+    }
+}
+
+Maze_chunk::Maze_chunk(const std::uint64_t world_seed, const int x, const int y, const unsigned int size,
+    const unsigned int room_attempts, const unsigned int wall_rm_attempts):
+    _x(x), _y(y),
+    _grid(size, size, Grid::MAZEGEN_DFS, room_attempts, wall_rm_attempts,
+        substream_seed(world_seed, chunk_stream(x, y, 0))),
+    _up_edge(gen_edge(world_seed, x, y, EDGE_UP, size)),
+    _left_edge(gen_edge(world_seed, x, y, EDGE_LEFT, size))
+{
+}
+
+Bit_plane Maze_chunk::gen_edge(const std::uint64_t world_seed, const int x, const int y,
+    const Edge edge, const unsigned int size)
+{
+    Mazegen_rng prng(substream_seed(world_seed, chunk_stream(x, y, edge == EDGE_UP ? 1 : 2)));
+    std::uniform_int_distribution<unsigned int> pos(0, size - 1);
+
+    // one guaranteed opening, plus a few more so the maze doesn't funnel
+    // through a single cell between chunks
+    Bit_plane walls(size, true);
+    walls.set(pos(prng), false);
+    for(unsigned int i = 0; i < size / 16; ++i)
+        walls.set(pos(prng), false);
+
+    return walls;
+}
@@ -0,0 +1,99 @@
+// maze_chunk.hpp
+// piece of an endless maze, generated independently of its neighbors
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MAZE_CHUNK_HPP
+#define MAZE_CHUNK_HPP
+
+#include <cstdint>
+
+#include "mazegen/bit_plane.hpp"
+#include "mazegen/grid.hpp"
+
+// square chunk of an endless maze, at chunk coords (x, y). Each chunk is a
+// complete maze of its own, seeded from the world seed & its coords. Chunks
+// are joined by openings in the edges between them, which are generated from
+// the world seed alone, so neighbors always agree on them without either
+// having to exist
+class Maze_chunk final
+{
+public:
+    Maze_chunk(const std::uint64_t world_seed, const int x, const int y, const unsigned int size,
+        const unsigned int room_attempts, const unsigned int wall_rm_attempts);
+
+    int x() const;
+    int y() const;
+    unsigned int size() const;
+
+    // the chunk's cells. Walls on the grid's border are replaced by up_edge &
+    // left_edge, and by the neighboring chunks' edges
+    const Grid & grid() const;
+
+    // walls along the top & left edges. bit i is set if cell i of the top row /
+    // left column has a wall on that side. The bottom & right edges belong to
+    // the chunks below & to the right
+    const Bit_plane & up_edge() const;
+    const Bit_plane & left_edge() const;
+
+    enum Edge {EDGE_UP, EDGE_LEFT};
+    // walls on the given edge of chunk (x, y). Each edge has at least one opening
+    static Bit_plane gen_edge(const std::uint64_t world_seed, const int x, const int y,
+        const Edge edge, const unsigned int size);
+
+private:
+    int _x, _y;
+    Grid _grid;
+    Bit_plane _up_edge;
+    Bit_plane _left_edge;
+};
+
+inline int Maze_chunk::x() const
+{
+    return _x;
+}
+
+inline int Maze_chunk::y() const
+{
+    return _y;
+}
+
+inline unsigned int Maze_chunk::size() const
+{
+    return _grid.width();
+}
+
+inline const Grid & Maze_chunk::grid() const
+{
+    return _grid;
+}
+
+inline const Bit_plane & Maze_chunk::up_edge() const
+{
+    return _up_edge;
+}
+
+inline const Bit_plane & Maze_chunk::left_edge() const
+{
+    return _left_edge;
+}
+
+#endif // MAZE_CHUNK_HPP
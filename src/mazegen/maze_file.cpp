@@ -0,0 +1,302 @@
+// maze_file.cpp
+// versioned binary maze file, memory mapped for loading
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mazegen/maze_file.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "util/logger.hpp"
+
+const char Maze_file_header::magic_str[8] = {'M', 'A', 'Z', 'E', 'G', 'R', 'I', 'D'};
+const std::uint32_t Maze_file_header::current_version;
+const std::uint32_t Maze_file_header::v1_header_size;
+const std::uint32_t Maze_file_header::byte_order_mark;
+const std::uint32_t Maze_file_header::mazegen_unknown;
+const std::uint32_t Maze_file_header::mazegen_binary_tree;
+const std::uint32_t Maze_file_header::mazegen_sidewinder;
+const std::uint32_t Maze_file_header::attempts_unknown;
+
+void write_maze_file(const std::string & filename, const Grid & grid, const std::uint32_t mazegen,
+    const std::uint32_t room_attempts, const std::uint32_t wall_rm_attempts)
+{
+    Logger_locator::get()(Logger::DBG, "Writing maze file: " + filename);
+
+    Maze_file_header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, Maze_file_header::magic_str, sizeof(header.magic));
+    header.version = Maze_file_header::current_version;
+    header.byte_order = Maze_file_header::byte_order_mark;
+    header.header_size = sizeof(header);
+    header.width = grid.width();
+    header.height = grid.height();
+    header.mazegen = mazegen;
+    header.seed = grid.seed();
+    header.room_attempts = room_attempts;
+    header.wall_rm_attempts = wall_rm_attempts;
+    header.row_words = (grid.width() + Bit_plane::word_bits - 1) / Bit_plane::word_bits;
+    header.right_offset = sizeof(header);
+    header.down_offset = header.right_offset + header.row_words * sizeof(std::uint64_t) * grid.height();
+
+    std::ofstream out(filename, std::ios_base::binary);
+    if(!out)
+    {
+        Logger_locator::get()(Logger::ERROR, "Error opening maze file for writing: " + filename);
+        throw std::ios_base::failure("Error opening maze file for writing: " + filename);
+    }
+
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    // bits past the last cell are set in Maze_row (borders). clear them
+    std::uint64_t last_mask = grid.width() % Bit_plane::word_bits == 0 ? ~(std::uint64_t)0 :
+        ((std::uint64_t)1 << (grid.width() % Bit_plane::word_bits)) - 1;
+
+    // one plane at a time, so each is contiguous
+    for(int plane = 0; plane < 2; ++plane)
+    {
+        Grid_row_reader rows(grid);
+        Maze_row row;
+        std::vector<std::uint64_t> words(header.row_words);
+        while(rows.next_row(row))
+        {
+            const Bit_plane & bits = plane == 0 ? row.right : row.down;
+            std::memcpy(words.data(), bits.data(), words.size() * sizeof(std::uint64_t));
+            words.back() &= last_mask;
+            out.write(reinterpret_cast<const char *>(words.data()), words.size() * sizeof(std::uint64_t));
+        }
+    }
+
+    if(!out)
+    {
+        Logger_locator::get()(Logger::ERROR, "Error writing maze file: " + filename);
+        throw std::ios_base::failure("Error writing maze file: " + filename);
+    }
+}
+
+Maze_file::Maze_file(const std::string & filename): _filename(filename)
+{
+    Logger_locator::get()(Logger::DBG, "Mapping maze file: " + filename);
+
+    #ifdef _WIN32
+        HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if(file == INVALID_HANDLE_VALUE)
+        {
+            Logger_locator::get()(Logger::ERROR, "Error opening maze file: " + filename);
+            throw std::system_error(GetLastError(), std::system_category(), "Error opening maze file: " + filename);
+        }
+        _file_handle = file;
+
+        LARGE_INTEGER size;
+        if(!GetFileSizeEx(file, &size))
+        {
+            DWORD err = GetLastError();
+            unmap();
+            Logger_locator::get()(Logger::ERROR, "Error reading maze file size: " + filename);
+            throw std::system_error(err, std::system_category(), "Error reading maze file size: " + filename);
+        }
+        _map_size = (std::size_t)size.QuadPart;
+
+        if(_map_size > 0)
+        {
+            _map_handle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+            if(_map_handle)
+                _map = static_cast<const unsigned char *>(MapViewOfFile(_map_handle, FILE_MAP_READ, 0, 0, 0));
+
+            if(!_map)
+            {
+                DWORD err = GetLastError();
+                unmap();
+                Logger_locator::get()(Logger::ERROR, "Error mapping maze file: " + filename);
+                throw std::system_error(err, std::system_category(), "Error mapping maze file: " + filename);
+            }
+        }
+    #else
+        int fd = open(filename.c_str(), O_RDONLY);
+        if(fd < 0)
+        {
+            Logger_locator::get()(Logger::ERROR, "Error opening maze file: " + filename);
+            throw std::system_error(errno, std::system_category(), "Error opening maze file: " + filename);
+        }
+
+        struct stat st;
+        if(fstat(fd, &st) != 0)
+        {
+            int err = errno;
+            close(fd);
+            Logger_locator::get()(Logger::ERROR, "Error reading maze file size: " + filename);
+            throw std::system_error(err, std::system_category(), "Error reading maze file size: " + filename);
+        }
+        _map_size = (std::size_t)st.st_size;
+
+        if(_map_size > 0)
+        {
+            void * map = mmap(nullptr, _map_size, PROT_READ, MAP_SHARED, fd, 0);
+            if(map == MAP_FAILED)
+            {
+                int err = errno;
+                close(fd);
+                Logger_locator::get()(Logger::ERROR, "Error mapping maze file: " + filename);
+                throw std::system_error(err, std::system_category(), "Error mapping maze file: " + filename);
+            }
+            _map = static_cast<const unsigned char *>(map);
+        }
+
+        // the mapping keeps the file open
+        close(fd);
+    #endif
+
+    auto invalid = [this](const std::string & msg)
+    {
+        unmap();
+        Logger_locator::get()(Logger::ERROR, "Invalid maze file (" + _filename + "): " + msg);
+        throw std::runtime_error("Invalid maze file (" + _filename + "): " + msg);
+    };
+
+    // enough to read the version. Newer fields are checked against header_size below
+    if(_map_size < Maze_file_header::v1_header_size)
+        invalid("too short for header");
+
+    _header = reinterpret_cast<const Maze_file_header *>(_map);
+
+    if(std::memcmp(_header->magic, Maze_file_header::magic_str, sizeof(_header->magic)) != 0)
+        invalid("bad magic");
+    if(_header->byte_order != Maze_file_header::byte_order_mark)
+        invalid("byte order doesn't match this machine");
+    if(_header->version < 1 || _header->version > Maze_file_header::current_version)
+        invalid("unsupported version " + std::to_string(_header->version));
+    if(_header->header_size < (_header->version == 1 ? Maze_file_header::v1_header_size : sizeof(Maze_file_header)))
+        invalid("header too short");
+    if(_header->header_size > _map_size)
+        invalid("too short for header");
+    if(_header->width == 0 || _header->height == 0)
+        invalid("empty grid");
+    if(_header->row_words != (_header->width + Bit_plane::word_bits - 1) / Bit_plane::word_bits)
+        invalid("row size doesn't match width");
+
+    // checked in 64 bits, so a bad header can't overflow
+    std::uint64_t plane_size = _header->row_words * sizeof(std::uint64_t) * _header->height;
+    for(std::uint64_t offset: {_header->right_offset, _header->down_offset})
+    {
+        if(offset % sizeof(std::uint64_t) != 0 || offset < _header->header_size ||
+            offset > _map_size || plane_size > _map_size - offset)
+        {
+            invalid("wall plane out of bounds");
+        }
+    }
+
+    _right = reinterpret_cast<const std::uint64_t *>(_map + _header->right_offset);
+    _down = reinterpret_cast<const std::uint64_t *>(_map + _header->down_offset);
+
+    Logger_locator::get()(Logger::DBG, "Mapped " + std::to_string(width()) + "x" + std::to_string(height()) +
+        " maze, seed: " + std::to_string(seed()));
+}
+
+Maze_file::~Maze_file()
+{
+    unmap();
+}
+
+void Maze_file::unmap()
+{
+    #ifdef _WIN32
+        if(_map)
+            UnmapViewOfFile(_map);
+        if(_map_handle)
+            CloseHandle(_map_handle);
+        if(_file_handle)
+            CloseHandle(_file_handle);
+        _map_handle = _file_handle = nullptr;
+    #else
+        if(_map)
+            munmap(const_cast<unsigned char *>(_map), _map_size);
+    #endif
+
+    _map = nullptr;
+    _map_size = 0;
+    _header = nullptr;
+}
+
+std::unique_ptr<Grid> Maze_file::to_grid() const
+{
+    std::unique_ptr<Grid> grid(new Grid(width(), height(), seed()));
+
+    for(unsigned int row = 0; row < height(); ++row)
+    {
+        for(unsigned int col = 0; col < width(); ++col)
+        {
+            grid->set_wall(col, row, RIGHT, wall(col, row, RIGHT));
+            grid->set_wall(col, row, DOWN, wall(col, row, DOWN));
+            grid->set_visited(col, row, true);
+        }
+    }
+
+    return grid;
+}
+
+Maze_file_row_reader::Maze_file_row_reader(const Maze_file & file): _file(file)
+{
+}
+
+unsigned int Maze_file_row_reader::width() const
+{
+    return _file.width();
+}
+
+unsigned int Maze_file_row_reader::height() const
+{
+    return _file.height();
+}
+
+bool Maze_file_row_reader::next_row(Maze_row & row_out)
+{
+    if(_row >= _file.height())
+        return false;
+
+    row_out.right.assign(_file.width(), true);
+    row_out.down.assign(_file.width(), true);
+
+    std::memcpy(row_out.right.data(), _file.right_row(_row), _file.row_words() * sizeof(std::uint64_t));
+    std::memcpy(row_out.down.data(), _file.down_row(_row), _file.row_words() * sizeof(std::uint64_t));
+
+    // borders are always walls, whatever the file says
+    row_out.right.set(_file.width() - 1, true);
+    if(_row == _file.height() - 1)
+        row_out.down.assign(_file.width(), true);
+
+    ++_row;
+    return true;
+}
@@ -0,0 +1,207 @@
+// maze_file.hpp
+// versioned binary maze file, memory mapped for loading
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MAZE_FILE_HPP
+#define MAZE_FILE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "mazegen/grid.hpp"
+#include "mazegen/maze_row.hpp"
+
+// File layout. All fields are in native byte order, which is checked against
+// byte_order on load.
+//
+// [0, header_size)              Maze_file_header
+// [right_offset, + plane size)  right walls
+// [down_offset, + plane size)   down walls
+//
+// Each plane is height rows of row_words 64-bit words. Bit x of a row's words
+// (LSB first) is set if cell x has a wall on that side, as in Maze_row.
+// Padding bits past width are 0. Offsets are multiples of 8, so rows can be
+// read in place
+//
+// Version 1 headers end after down_offset (v1_header_size bytes), and don't
+// record the room & wall removal attempts
+struct Maze_file_header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint32_t header_size;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t mazegen; // Grid::Mazegen_alg used, mazegen_binary_tree, mazegen_sidewinder, or mazegen_unknown
+    std::uint64_t seed;
+    std::uint64_t row_words;
+    std::uint64_t right_offset;
+    std::uint64_t down_offset;
+    std::uint32_t room_attempts; // or attempts_unknown
+    std::uint32_t wall_rm_attempts; // or attempts_unknown
+
+    static const char magic_str[8];
+    static const std::uint32_t current_version = 2;
+    static const std::uint32_t v1_header_size = 64;
+    static const std::uint32_t byte_order_mark = 0x01020304;
+    static const std::uint32_t mazegen_unknown = 0xFFFFFFFF;
+    // bulk generators, which aren't Grid::Mazegen_alg values
+    static const std::uint32_t mazegen_binary_tree = 0x100;
+    static const std::uint32_t mazegen_sidewinder = 0x101;
+    static const std::uint32_t attempts_unknown = 0xFFFFFFFF;
+};
+
+static_assert(sizeof(Maze_file_header) == 72, "Maze_file_header must be packed to 72 bytes");
+
+// write grid's walls to filename. The settings it was generated with are
+// recorded in the header, and may be left unknown
+void write_maze_file(const std::string & filename, const Grid & grid,
+    const std::uint32_t mazegen = Maze_file_header::mazegen_unknown,
+    const std::uint32_t room_attempts = Maze_file_header::attempts_unknown,
+    const std::uint32_t wall_rm_attempts = Maze_file_header::attempts_unknown);
+
+// read-only memory mapped maze file. Walls are read straight out of the
+// mapping, so loading costs nothing up front, and processes using the same
+// file share its pages
+class Maze_file final
+{
+public:
+    // maps & validates the file. throws on error
+    explicit Maze_file(const std::string & filename);
+    ~Maze_file();
+    Maze_file(const Maze_file &) = delete;
+    Maze_file & operator=(const Maze_file &) = delete;
+
+    unsigned int width() const;
+    unsigned int height() const;
+    std::uint64_t seed() const;
+    std::uint32_t mazegen() const;
+    // attempts_unknown for version 1 files
+    std::uint32_t room_attempts() const;
+    std::uint32_t wall_rm_attempts() const;
+
+    // same as Grid::wall
+    bool wall(const unsigned int x, const unsigned int y, const Direction dir) const;
+
+    // row_words() words of the given row in each plane
+    std::size_t row_words() const;
+    const std::uint64_t * right_row(const unsigned int y) const;
+    const std::uint64_t * down_row(const unsigned int y) const;
+
+    // copy into an editable grid, seeded with the file's seed
+    std::unique_ptr<Grid> to_grid() const;
+
+private:
+    void unmap();
+
+    std::string _filename;
+    const unsigned char * _map = nullptr;
+    std::size_t _map_size = 0;
+    #ifdef _WIN32
+        void * _file_handle = nullptr;
+        void * _map_handle = nullptr;
+    #endif
+
+    const Maze_file_header * _header = nullptr;
+    const std::uint64_t * _right = nullptr;
+    const std::uint64_t * _down = nullptr;
+};
+
+// reads rows out of a maze file
+class Maze_file_row_reader final: public Maze_row_source
+{
+public:
+    Maze_file_row_reader(const Maze_file & file);
+    unsigned int width() const;
+    unsigned int height() const;
+    bool next_row(Maze_row & row_out);
+
+private:
+    const Maze_file & _file;
+    unsigned int _row = 0;
+};
+
+inline unsigned int Maze_file::width() const
+{
+    return _header->width;
+}
+
+inline unsigned int Maze_file::height() const
+{
+    return _header->height;
+}
+
+inline std::uint64_t Maze_file::seed() const
+{
+    return _header->seed;
+}
+
+inline std::uint32_t Maze_file::mazegen() const
+{
+    return _header->mazegen;
+}
+
+// version 1 headers stop before these fields, so don't read past them
+inline std::uint32_t Maze_file::room_attempts() const
+{
+    return _header->version >= 2 ? _header->room_attempts : Maze_file_header::attempts_unknown;
+}
+
+inline std::uint32_t Maze_file::wall_rm_attempts() const
+{
+    return _header->version >= 2 ? _header->wall_rm_attempts : Maze_file_header::attempts_unknown;
+}
+
+inline std::size_t Maze_file::row_words() const
+{
+    return (std::size_t)_header->row_words;
+}
+
+inline const std::uint64_t * Maze_file::right_row(const unsigned int y) const
+{
+    return _right + (std::size_t)y * row_words();
+}
+
+inline const std::uint64_t * Maze_file::down_row(const unsigned int y) const
+{
+    return _down + (std::size_t)y * row_words();
+}
+
+inline bool Maze_file::wall(const unsigned int x, const unsigned int y, const Direction dir) const
+{
+    switch(dir)
+    {
+    case UP:
+        return y == 0 || ((down_row(y - 1)[x / 64] >> (x % 64)) & 1);
+    case DOWN:
+        return y == height() - 1 || ((down_row(y)[x / 64] >> (x % 64)) & 1);
+    case LEFT:
+        return x == 0 || ((right_row(y)[(x - 1) / 64] >> ((x - 1) % 64)) & 1);
+    case RIGHT:
+        return x == width() - 1 || ((right_row(y)[x / 64] >> (x % 64)) & 1);
+    }
+    return true;
+}
+
+#endif // MAZE_FILE_HPP
@@ -0,0 +1,58 @@
+// maze_row.cpp
+// row-at-a-time maze wall access
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mazegen/maze_row.hpp"
+
+#include "mazegen/grid.hpp"
+
+Grid_row_reader::Grid_row_reader(const Grid & grid): _grid(grid)
+{
+}
+
+unsigned int Grid_row_reader::width() const
+{
+    return _grid.width();
+}
+
+unsigned int Grid_row_reader::height() const
+{
+    return _grid.height();
+}
+
+bool Grid_row_reader::next_row(Maze_row & row_out)
+{
+    if(_row >= _grid.height())
+        return false;
+
+    row_out.right.assign(_grid.width(), true);
+    row_out.down.assign(_grid.width(), true);
+
+    for(unsigned int col = 0; col < _grid.width(); ++col)
+    {
+        row_out.right.set(col, _grid.wall(col, _row, RIGHT));
+        row_out.down.set(col, _grid.wall(col, _row, DOWN));
+    }
+
+    ++_row;
+    return true;
+}
@@ -0,0 +1,66 @@
+// maze_row.hpp
+// row-at-a-time maze wall access
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MAZE_ROW_HPP
+#define MAZE_ROW_HPP
+
+#include "mazegen/bit_plane.hpp"
+
+class Grid;
+
+// walls of one row of cells. bit x of right / down is set if cell x has a wall
+// on that side. The last cell's right wall and the last row's down walls are
+// borders, and always set
+struct Maze_row
+{
+    Bit_plane right;
+    Bit_plane down;
+};
+
+// pull-style source of maze rows, from top to bottom
+class Maze_row_source
+{
+public:
+    virtual ~Maze_row_source() = default;
+    virtual unsigned int width() const = 0;
+    // 0 for an endless source
+    virtual unsigned int height() const = 0;
+    // write the next row to row_out. returns false when there are no more rows
+    virtual bool next_row(Maze_row & row_out) = 0;
+};
+
+// reads rows out of an existing grid
+class Grid_row_reader final: public Maze_row_source
+{
+public:
+    Grid_row_reader(const Grid & grid);
+    unsigned int width() const;
+    unsigned int height() const;
+    bool next_row(Maze_row & row_out);
+
+private:
+    const Grid & _grid;
+    unsigned int _row = 0;
+};
+
+#endif // MAZE_ROW_HPP
@@ -0,0 +1,84 @@
+// maze_stats.cpp
+// shape statistics of a generated maze
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "mazegen/maze_stats.hpp"
+
+#include <vector>
+
+#include "mazegen/grid.hpp"
+#include "mazegen/nav_graph.hpp"
+
+namespace
+{
+    // reachable node farthest from source, and its distance
+    Nav_graph::Node farthest(const Nav_graph & graph, const Nav_graph::Node source,
+        std::vector<std::uint32_t> & dist, std::uint32_t & max_dist)
+    {
+        graph.dijkstra(source, dist);
+
+        Nav_graph::Node far_node = source;
+        max_dist = 0;
+        for(Nav_graph::Node node = 0; node < dist.size(); ++node)
+        {
+            if(dist[node] != Nav_graph::unreachable && dist[node] > max_dist)
+            {
+                far_node = node;
+                max_dist = dist[node];
+            }
+        }
+        return far_node;
+    }
+}
+
+Maze_stats get_maze_stats(const Grid & grid)
+{
+    Maze_stats stats = {};
+    Nav_graph graph(grid);
+
+    // every cell not in a corridor is a node, so its degree is its number of
+    // open sides
+    std::size_t branches = 0;
+    for(Nav_graph::Node node = 0; node < graph.num_nodes(); ++node)
+    {
+        std::size_t degree = graph.edge_end(node) - graph.edge_begin(node);
+        if(degree == 1)
+            ++stats.dead_ends;
+        else if(degree >= 3)
+        {
+            ++stats.junctions;
+            branches += degree - 1;
+        }
+    }
+    if(stats.junctions > 0)
+        stats.branching_factor = (double)branches / stats.junctions;
+
+    // the farthest node from any node is one end of the longest path in a
+    // tree, and the farthest from that is the other. With loops, it's only a
+    // lower bound: an exact answer needs a search from every node
+    std::vector<std::uint32_t> dist;
+    std::uint32_t max_dist;
+    farthest(graph, farthest(graph, 0, dist, max_dist), dist, stats.longest_path_lb);
+
+    return stats;
+}
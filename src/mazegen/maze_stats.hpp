@@ -0,0 +1,50 @@
+// maze_stats.hpp
+// shape statistics of a generated maze
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef MAZE_STATS_HPP
+#define MAZE_STATS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+class Grid;
+
+struct Maze_stats
+{
+    std::size_t dead_ends; // cells with 1 open side
+    std::size_t junctions; // cells with 3 or more open sides
+    // mean choices of way on at a junction (open sides less the one entered by)
+    double branching_factor;
+    // steps along the longest shortest path found by a double sweep, in the
+    // part of the maze joined to the first dead end or junction in row-major
+    // order. Exact only for perfect mazes. When rooms or wall removal have
+    // made loops it is a lower bound, and may be well short of the true
+    // longest path
+    std::uint32_t longest_path_lb;
+};
+
+// computed over the grid's Nav_graph
+Maze_stats get_maze_stats(const Grid & grid);
+
+#endif // MAZE_STATS_HPP
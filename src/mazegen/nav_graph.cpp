@@ -0,0 +1,313 @@
+// nav_graph.cpp
+// compact graph of a maze's junctions & dead ends
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "mazegen/nav_graph.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "util/parallel.hpp"
+
+namespace
+{
+    // smallest slice of a BFS level given to a worker thread
+    const std::size_t min_frontier_chunk = 4096;
+
+    // nodes per block when filling in edges. Small graphs are one block, and
+    // don't start any threads
+    const std::size_t nodes_per_block = 1 << 16;
+
+    // UP & DOWN, and LEFT & RIGHT, are adjacent in Direction
+    Direction opposite(const Direction dir)
+    {
+        return (Direction)(dir ^ 1);
+    }
+
+    unsigned int num_sides(std::uint8_t sides)
+    {
+        unsigned int count = 0;
+        for(; sides; sides &= sides - 1)
+            ++count;
+        return count;
+    }
+
+    Direction first_side(const std::uint8_t sides)
+    {
+        for(Direction dir: {UP, DOWN, LEFT, RIGHT})
+        {
+            if(sides & (1 << dir))
+                return dir;
+        }
+        return UP;
+    }
+
+    std::uint32_t step(const std::uint32_t cell, const Direction dir, const unsigned int width)
+    {
+        switch(dir)
+        {
+        case UP:
+            return cell - width;
+        case DOWN:
+            return cell + width;
+        case LEFT:
+            return cell - 1;
+        case RIGHT:
+        default:
+            return cell + 1;
+        }
+    }
+
+    // follow the corridor leaving cell through dir, to the next cell that isn't
+    // 2-sided, or back to cell around a loop. Sets steps to its length, and
+    // marks the 2-sided cells passed in covered, if not null
+    std::uint32_t follow(const std::vector<std::uint8_t> & sides, const unsigned int width,
+        const std::uint32_t start, Direction dir, std::uint32_t & steps, Bit_plane * covered)
+    {
+        std::uint32_t cell = start;
+        for(steps = 1;; ++steps)
+        {
+            cell = step(cell, dir, width);
+            if(cell == start || num_sides(sides[cell]) != 2)
+                return cell;
+
+            if(covered)
+                covered->set(cell, true);
+            dir = first_side(sides[cell] & ~(1 << opposite(dir)));
+        }
+    }
+}
+
+Nav_graph::Nav_graph(const Grid & grid):
+    _width(grid.width()), _height(grid.height())
+{
+    if((std::uint64_t)_width * _height >= no_node)
+    {
+        throw std::invalid_argument("grid too large for nav graph: " +
+            std::to_string(_width) + "x" + std::to_string(_height));
+    }
+
+    std::size_t size = (std::size_t)_width * _height;
+    std::vector<std::uint8_t> sides;
+    grid.open_sides(sides);
+
+    // walk every corridor from the cells that aren't 2-sided. Any 2-sided cells
+    // not reached are on loops with no other node, and the first cell of each
+    // becomes one
+    Bit_plane covered(size, false);
+    std::uint32_t steps;
+    for(Cell cell = 0; cell < size; ++cell)
+    {
+        if(num_sides(sides[cell]) == 2)
+            continue;
+
+        for(Direction dir: {UP, DOWN, LEFT, RIGHT})
+        {
+            if(sides[cell] & (1 << dir))
+                follow(sides, _width, cell, dir, steps, &covered);
+        }
+    }
+
+    _is_node.assign(size, false);
+    for(Cell cell = 0; cell < size; ++cell)
+    {
+        if(num_sides(sides[cell]) != 2)
+            _is_node.set(cell, true);
+        else if(!covered.get(cell))
+        {
+            _is_node.set(cell, true);
+            covered.set(cell, true);
+            follow(sides, _width, cell, first_side(sides[cell]), steps, &covered);
+        }
+    }
+
+    _word_rank.resize(_is_node.num_words());
+    Node count = 0;
+    for(std::size_t word = 0; word < _is_node.num_words(); ++word)
+    {
+        _word_rank[word] = count;
+        for(Bit_plane::Word bits = _is_node.data()[word]; bits; bits &= bits - 1)
+        {
+            _node_cell.push_back(word * Bit_plane::word_bits + lowest_bit(bits));
+            ++count;
+        }
+    }
+
+    // each node has an edge per open side
+    std::size_t num_nodes = _node_cell.size();
+    _edge_first.resize(num_nodes + 1);
+    _edge_first[0] = 0;
+    for(Node node = 0; node < num_nodes; ++node)
+        _edge_first[node + 1] = _edge_first[node] + num_sides(sides[_node_cell[node]]);
+
+    _edge_target.resize(_edge_first[num_nodes]);
+    _edge_weight.resize(_edge_first[num_nodes]);
+
+    std::size_t num_blocks = (num_nodes + nodes_per_block - 1) / nodes_per_block;
+    auto fill_block = [this, &sides, num_nodes](const std::size_t block)
+    {
+        Node node_end = std::min(num_nodes, (block + 1) * nodes_per_block);
+        for(Node node = block * nodes_per_block; node < node_end; ++node)
+        {
+            std::size_t edge = _edge_first[node];
+            for(Direction dir: {UP, DOWN, LEFT, RIGHT})
+            {
+                if(!(sides[_node_cell[node]] & (1 << dir)))
+                    continue;
+
+                std::uint32_t target = follow(sides, _width, _node_cell[node], dir, _edge_weight[edge], nullptr);
+                _edge_target[edge++] = rank(target);
+            }
+        }
+    };
+
+    if(num_blocks <= 1)
+        fill_block(0);
+    else
+        parallel_for(num_blocks, fill_block);
+}
+
+Nav_graph::Node Nav_graph::node_at(const unsigned int x, const unsigned int y) const
+{
+    Cell cell = y * _width + x;
+    return _is_node.get(cell) ? rank(cell) : no_node;
+}
+
+// level by level. Large levels are split among worker threads, which claim
+// nodes by swapping their level from unreachable
+void Nav_graph::bfs(const Node source, std::vector<std::uint32_t> & hops, const unsigned int num_threads) const
+{
+    unsigned int threads = num_threads == 0 ? default_num_threads() : num_threads;
+    std::size_t num_nodes = _node_cell.size();
+
+    std::unique_ptr<std::atomic<std::uint32_t>[]> level(new std::atomic<std::uint32_t>[num_nodes]);
+    for(std::size_t i = 0; i < num_nodes; ++i)
+        level[i].store(unreachable, std::memory_order_relaxed);
+
+    // claim the unreached neighbors of frontier[begin, end)
+    auto search = [this, &level](const std::vector<Node> & frontier, const std::size_t begin, const std::size_t end,
+        const std::uint32_t depth, const bool shared, std::vector<Node> & next_frontier)
+    {
+        for(std::size_t i = begin; i < end; ++i)
+        {
+            for(std::size_t edge = _edge_first[frontier[i]]; edge < _edge_first[frontier[i] + 1]; ++edge)
+            {
+                Node target = _edge_target[edge];
+                std::uint32_t expected = unreachable;
+                if(level[target].load(std::memory_order_relaxed) != unreachable)
+                    continue;
+
+                if(!shared)
+                    level[target].store(depth + 1, std::memory_order_relaxed);
+                else if(!level[target].compare_exchange_strong(expected, depth + 1, std::memory_order_relaxed))
+                    continue;
+
+                next_frontier.push_back(target);
+            }
+        }
+    };
+
+    std::vector<Node> frontier = {source}, next_frontier;
+    std::vector<std::vector<Node>> chunk_frontiers;
+    level[source].store(0, std::memory_order_relaxed);
+
+    for(std::uint32_t depth = 0; !frontier.empty(); ++depth)
+    {
+        next_frontier.clear();
+
+        std::size_t num_chunks = std::min<std::size_t>(threads, frontier.size() / min_frontier_chunk);
+        if(num_chunks > 1)
+        {
+            chunk_frontiers.resize(num_chunks);
+            parallel_for(num_chunks, [&](const std::size_t chunk)
+            {
+                chunk_frontiers[chunk].clear();
+                search(frontier, frontier.size() * chunk / num_chunks,
+                    frontier.size() * (chunk + 1) / num_chunks, depth, true, chunk_frontiers[chunk]);
+            }, threads);
+
+            for(const auto & chunk_frontier: chunk_frontiers)
+                next_frontier.insert(next_frontier.end(), chunk_frontier.begin(), chunk_frontier.end());
+        }
+        else
+            search(frontier, 0, frontier.size(), depth, false, next_frontier);
+
+        frontier.swap(next_frontier);
+    }
+
+    hops.resize(num_nodes);
+    for(std::size_t i = 0; i < num_nodes; ++i)
+        hops[i] = level[i].load(std::memory_order_relaxed);
+}
+
+void Nav_graph::dijkstra(const Node source, std::vector<std::uint32_t> & dist) const
+{
+    typedef std::pair<std::uint32_t, Node> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+
+    dist.assign(_node_cell.size(), (std::uint32_t)unreachable);
+    dist[source] = 0;
+    open.emplace(0, source);
+
+    // a node may be pushed again when a shorter path to it is found. The
+    // stale entry is skipped when popped
+    while(!open.empty())
+    {
+        Entry entry = open.top();
+        open.pop();
+        if(entry.first != dist[entry.second])
+            continue;
+
+        for(std::size_t edge = _edge_first[entry.second]; edge < _edge_first[entry.second + 1]; ++edge)
+        {
+            std::uint32_t target_dist = entry.first + _edge_weight[edge];
+            if(target_dist < dist[_edge_target[edge]])
+            {
+                dist[_edge_target[edge]] = target_dist;
+                open.emplace(target_dist, _edge_target[edge]);
+            }
+        }
+    }
+}
+
+inline Nav_graph::Node Nav_graph::rank(const Cell cell) const
+{
+    Bit_plane::Word before = ((Bit_plane::Word)1 << (cell % Bit_plane::word_bits)) - 1;
+    return _word_rank[cell / Bit_plane::word_bits] + count_bits(_is_node.data()[cell / Bit_plane::word_bits] & before);
+}
+
+void Nav_graph::dijkstra_each(const std::vector<Node> & sources, std::vector<std::vector<std::uint32_t>> & dists,
+    const unsigned int num_threads) const
+{
+    dists.resize(sources.size());
+    parallel_for(sources.size(), [this, &sources, &dists](const std::size_t i)
+    {
+        dijkstra(sources[i], dists[i]);
+    }, num_threads);
+}
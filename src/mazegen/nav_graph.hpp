@@ -0,0 +1,147 @@
+// nav_graph.hpp
+// compact graph of a maze's junctions & dead ends
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef NAV_GRAPH_HPP
+#define NAV_GRAPH_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <SFML/System.hpp>
+
+#include "mazegen/bit_plane.hpp"
+#include "mazegen/grid.hpp"
+
+// a grid compiled into an undirected graph in compressed sparse row form.
+// Every cell that doesn't have exactly 2 open sides (junctions, dead ends &
+// closed off cells) is a node, and each corridor of 2-sided cells between 2
+// nodes is a single edge, weighted by its length in steps. A loop made only of
+// 2-sided cells gets one node, on its first cell in row-major order, with the
+// loop as an edge back to itself in both directions.
+// Nodes are numbered in row-major order of their cells. Each edge is stored
+// once from each end, so a node's edges are in the same order as
+// UP, DOWN, LEFT, RIGHT from its cell. The walls are read when compiled, so
+// later changes to the grid aren't seen
+class Nav_graph final
+{
+public:
+    typedef std::uint32_t Node;
+    static const Node no_node = 0xFFFFFFFF;
+    static const std::uint32_t unreachable = 0xFFFFFFFF;
+
+    explicit Nav_graph(const Grid & grid);
+
+    std::size_t num_nodes() const;
+    // counting each edge from both ends
+    std::size_t num_edges() const;
+
+    sf::Vector2u node_pos(const Node node) const;
+    // node at (x, y), or no_node if it's inside a corridor
+    Node node_at(const unsigned int x, const unsigned int y) const;
+
+    // edges of node are [edge_begin(node), edge_end(node))
+    std::size_t edge_begin(const Node node) const;
+    std::size_t edge_end(const Node node) const;
+    Node edge_target(const std::size_t edge) const;
+    std::uint32_t edge_weight(const std::size_t edge) const;
+
+    // fewest edges from source to every node, or unreachable. Levels with
+    // enough nodes are split among num_threads workers (0 for hardware
+    // concurrency)
+    void bfs(const Node source, std::vector<std::uint32_t> & hops, const unsigned int num_threads = 1) const;
+    // shortest distance in steps from source to every node, or unreachable
+    void dijkstra(const Node source, std::vector<std::uint32_t> & dist) const;
+    // dijkstra from each source, with sources spread among num_threads
+    // workers (0 for hardware concurrency). dists[i] is from sources[i]
+    void dijkstra_each(const std::vector<Node> & sources, std::vector<std::vector<std::uint32_t>> & dists,
+        const unsigned int num_threads = 0) const;
+
+    unsigned int width() const;
+    unsigned int height() const;
+
+private:
+    typedef std::uint32_t Cell;
+
+    // nodes before cell, in row-major order
+    Node rank(const Cell cell) const;
+
+    unsigned int _width, _height;
+
+    std::vector<Cell> _node_cell; // row-major cell index of each node
+    // row-major, set for cells that are nodes. A node's number is its rank
+    // (the nodes before it), from the count before each word plus the bits
+    // before it in its word
+    Bit_plane _is_node;
+    std::vector<Node> _word_rank;
+    std::vector<std::size_t> _edge_first; // node n's edges are [_edge_first[n], _edge_first[n + 1])
+    std::vector<Node> _edge_target;
+    std::vector<std::uint32_t> _edge_weight;
+};
+
+inline std::size_t Nav_graph::num_nodes() const
+{
+    return _node_cell.size();
+}
+
+inline std::size_t Nav_graph::num_edges() const
+{
+    return _edge_target.size();
+}
+
+inline sf::Vector2u Nav_graph::node_pos(const Node node) const
+{
+    return sf::Vector2u(_node_cell[node] % _width, _node_cell[node] / _width);
+}
+
+inline std::size_t Nav_graph::edge_begin(const Node node) const
+{
+    return _edge_first[node];
+}
+
+inline std::size_t Nav_graph::edge_end(const Node node) const
+{
+    return _edge_first[node + 1];
+}
+
+inline Nav_graph::Node Nav_graph::edge_target(const std::size_t edge) const
+{
+    return _edge_target[edge];
+}
+
+inline std::uint32_t Nav_graph::edge_weight(const std::size_t edge) const
+{
+    return _edge_weight[edge];
+}
+
+inline unsigned int Nav_graph::width() const
+{
+    return _width;
+}
+
+inline unsigned int Nav_graph::height() const
+{
+    return _height;
+}
+
+#endif // NAV_GRAPH_HPP
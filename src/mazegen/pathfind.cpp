@@ -0,0 +1,342 @@
+// pathfind.cpp
+// shortest paths between grid cells
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "mazegen/pathfind.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    const Direction horiz_dirs[] = {LEFT, RIGHT};
+    const Direction vert_dirs[] = {UP, DOWN};
+
+    // ordering for the open list heap: lowest f on top, ties to the lowest h
+    template<typename Entry>
+    bool worse_entry(const Entry & a, const Entry & b)
+    {
+        return a.f > b.f || (a.f == b.f && a.h > b.h);
+    }
+
+    template<typename T>
+    T abs_diff(const T a, const T b)
+    {
+        return a > b ? a - b : b - a;
+    }
+}
+
+Pathfinder::Pathfinder(const Grid & grid):
+    _width(grid.width()), _height(grid.height())
+{
+    if((std::uint64_t)_width * _height >= no_cell)
+    {
+        throw std::invalid_argument("grid too large for pathfinding: " +
+            std::to_string(_width) + "x" + std::to_string(_height));
+    }
+
+    std::size_t size = (std::size_t)_width * _height;
+    _stamp.assign(size, 0);
+    _g.resize(size);
+    _parent.resize(size);
+
+    update_walls(grid);
+}
+
+void Pathfinder::update_walls(const Grid & grid)
+{
+    if(grid.width() != _width || grid.height() != _height)
+    {
+        throw std::invalid_argument("grid size changed from " +
+            std::to_string(_width) + "x" + std::to_string(_height) + " to " +
+            std::to_string(grid.width()) + "x" + std::to_string(grid.height()));
+    }
+
+    grid.open_sides(_open_sides);
+}
+
+bool Pathfinder::find_path(const sf::Vector2u & start, const sf::Vector2u & goal,
+    std::vector<sf::Vector2u> & path, const Method method)
+{
+    path.clear();
+    _num_expanded = 0;
+
+    if(start.x >= _width || start.y >= _height || goal.x >= _width || goal.y >= _height)
+    {
+        throw std::out_of_range("path endpoint off grid: (" +
+            std::to_string(start.x) + ", " + std::to_string(start.y) + ") to (" +
+            std::to_string(goal.x) + ", " + std::to_string(goal.y) + ")");
+    }
+
+    begin_query();
+
+    Cell start_cell = start.y * _width + start.x;
+    _goal = goal.y * _width + goal.x;
+    relax(start_cell, start_cell, 0);
+
+    if(!(method == JUMP_POINT ? search_jump_point() : search_a_star()))
+        return false;
+
+    // walk back from the goal. Jump point parents can be several cells away,
+    // always in a straight line, so fill in the cells between
+    path.reserve(_g[_goal] + 1);
+    for(Cell cell = _goal;; cell = _parent[cell])
+    {
+        Cell parent = _parent[cell];
+        sf::Vector2u pos(cell % _width, cell / _width);
+        sf::Vector2u parent_pos(parent % _width, parent / _width);
+
+        while(pos != parent_pos)
+        {
+            path.push_back(pos);
+            if(pos.x != parent_pos.x)
+                pos.x = pos.x < parent_pos.x ? pos.x + 1 : pos.x - 1;
+            else
+                pos.y = pos.y < parent_pos.y ? pos.y + 1 : pos.y - 1;
+        }
+
+        if(parent == cell)
+        {
+            path.push_back(pos);
+            break;
+        }
+    }
+    std::reverse(path.begin(), path.end());
+
+    return true;
+}
+
+void Pathfinder::begin_query()
+{
+    // stamps from older queries are never equal to either of this query's
+    // values, so nothing needs clearing until the counter wraps
+    if(_generation >= std::numeric_limits<std::uint32_t>::max() - 2)
+    {
+        std::fill(_stamp.begin(), _stamp.end(), 0);
+        _generation = 0;
+    }
+    _generation += 2;
+    _open_list.clear();
+}
+
+inline bool Pathfinder::seen(const Cell cell) const
+{
+    return _stamp[cell] - _generation <= 1;
+}
+
+inline bool Pathfinder::closed(const Cell cell) const
+{
+    return _stamp[cell] == _generation + 1;
+}
+
+// record a path to cell through parent, if it's shorter than any found so far
+inline void Pathfinder::relax(const Cell cell, const Cell parent, const std::uint32_t g)
+{
+    if(seen(cell) && (closed(cell) || g >= _g[cell]))
+        return;
+
+    _stamp[cell] = _generation;
+    _g[cell] = g;
+    _parent[cell] = parent;
+    push_open(cell, g);
+}
+
+// a cell may be pushed again when a shorter path to it is found. The stale
+// entry is skipped when popped, as the cell is closed by then
+inline void Pathfinder::push_open(const Cell cell, const std::uint32_t g)
+{
+    std::uint32_t h = estimate(cell);
+    _open_list.push_back({g + h, h, cell});
+    std::push_heap(_open_list.begin(), _open_list.end(), worse_entry<Open_entry>);
+}
+
+// returns no_cell when the open list runs out
+inline Pathfinder::Cell Pathfinder::pop_open()
+{
+    while(!_open_list.empty())
+    {
+        std::pop_heap(_open_list.begin(), _open_list.end(), worse_entry<Open_entry>);
+        Cell cell = _open_list.back().cell;
+        _open_list.pop_back();
+
+        if(!closed(cell))
+        {
+            _stamp[cell] = _generation + 1;
+            ++_num_expanded;
+            return cell;
+        }
+    }
+    return no_cell;
+}
+
+bool Pathfinder::search_a_star()
+{
+    for(Cell cell = pop_open(); cell != no_cell; cell = pop_open())
+    {
+        if(cell == _goal)
+            return true;
+
+        for(Direction dir: {UP, DOWN, LEFT, RIGHT})
+        {
+            if(open(cell, dir))
+                relax(step(cell, dir), cell, _g[cell] + 1);
+        }
+    }
+    return false;
+}
+
+bool Pathfinder::search_jump_point()
+{
+    for(Cell cell = pop_open(); cell != no_cell; cell = pop_open())
+    {
+        if(cell == _goal)
+            return true;
+
+        expand_jump_point(cell);
+    }
+    return false;
+}
+
+// Jump point search on a 4-connected grid. Of the equally short paths
+// between two cells, only those that make their vertical moves before their
+// horizontal ones are followed. Moving vertically, each cell branches both
+// ways horizontally, so a vertical jump stops wherever a horizontal one from
+// it would. Moving horizontally, a cell is only worth stopping at if it opens
+// up or down where the cell before it couldn't have gone up or down & across
+void Pathfinder::expand_jump_point(const Cell cell)
+{
+    Cell parent = _parent[cell];
+    std::uint32_t g = _g[cell];
+
+    auto try_dir = [this, cell, g](const Direction dir)
+    {
+        if(!open(cell, dir))
+            return;
+
+        bool horiz = dir == LEFT || dir == RIGHT;
+        Cell jump = horiz ? jump_horiz(cell, dir) : jump_vert(cell, dir);
+        if(jump == no_cell)
+            return;
+
+        std::uint32_t dist = horiz ? abs_diff(jump, cell) : abs_diff(jump, cell) / _width;
+        relax(jump, cell, g + dist);
+    };
+
+    if(parent == cell)
+    {
+        // start: everything is a natural neighbor
+        for(Direction dir: {UP, DOWN, LEFT, RIGHT})
+            try_dir(dir);
+    }
+    else if(parent / _width == cell / _width)
+    {
+        // arrived horizontally: keep going, and turn into any forced neighbors
+        Direction dir = parent < cell ? RIGHT : LEFT;
+        Cell prev = dir == RIGHT ? cell - 1 : cell + 1;
+
+        try_dir(dir);
+        for(Direction vert: vert_dirs)
+        {
+            if(open(cell, vert) && (!open(prev, vert) || !open(step(prev, vert), dir)))
+                try_dir(vert);
+        }
+    }
+    else
+    {
+        // arrived vertically: keep going, and branch both ways
+        try_dir(parent < cell ? DOWN : UP);
+        for(Direction horiz: horiz_dirs)
+            try_dir(horiz);
+    }
+}
+
+// first cell past cell, moving horizontally, that is the goal or has a forced
+// neighbor. no_cell if a wall comes first
+Pathfinder::Cell Pathfinder::jump_horiz(Cell cell, const Direction dir) const
+{
+    while(open(cell, dir))
+    {
+        Cell prev = cell;
+        cell = step(cell, dir);
+
+        if(cell == _goal)
+            return cell;
+
+        for(Direction vert: vert_dirs)
+        {
+            if(open(cell, vert) && (!open(prev, vert) || !open(step(prev, vert), dir)))
+                return cell;
+        }
+    }
+    return no_cell;
+}
+
+// first cell past cell, moving vertically, that is the goal or from which a
+// horizontal jump finds something. no_cell if a wall comes first
+Pathfinder::Cell Pathfinder::jump_vert(Cell cell, const Direction dir) const
+{
+    while(open(cell, dir))
+    {
+        cell = step(cell, dir);
+
+        if(cell == _goal)
+            return cell;
+
+        for(Direction horiz: horiz_dirs)
+        {
+            if(jump_horiz(cell, horiz) != no_cell)
+                return cell;
+        }
+    }
+    return no_cell;
+}
+
+// Manhattan distance to the goal. Never overestimates on a 4-connected grid
+inline std::uint32_t Pathfinder::estimate(const Cell cell) const
+{
+    return abs_diff(cell % _width, _goal % _width) + abs_diff(cell / _width, _goal / _width);
+}
+
+inline bool Pathfinder::open(const Cell cell, const Direction dir) const
+{
+    return _open_sides[cell] & (1 << dir);
+}
+
+// neighbor of cell, which must be open on that side
+inline Pathfinder::Cell Pathfinder::step(const Cell cell, const Direction dir) const
+{
+    switch(dir)
+    {
+    case UP:
+        return cell - _width;
+    case DOWN:
+        return cell + _width;
+    case LEFT:
+        return cell - 1;
+    case RIGHT:
+    default:
+        return cell + 1;
+    }
+}
@@ -0,0 +1,128 @@
+// pathfind.hpp
+// shortest paths between grid cells
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef PATHFIND_HPP
+#define PATHFIND_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <SFML/System.hpp>
+
+#include "mazegen/grid.hpp"
+
+// finds shortest paths between cells of a grid. The walls are copied into a
+// flat array of open sides when constructed (or on update_walls), so later
+// changes to the grid aren't seen until then.
+// All per-query state lives in flat arrays allocated once, and is invalidated
+// by bumping a generation counter rather than cleared, so a query allocates
+// nothing (given a reused path vector). Not thread safe: use one Pathfinder
+// per thread
+class Pathfinder final
+{
+public:
+    // A_STAR expands every cell it reaches. JUMP_POINT only stops at cells where
+    // the path may turn, so it skips along corridors & across open rooms.
+    // Both find shortest paths
+    typedef enum {A_STAR, JUMP_POINT} Method;
+
+    explicit Pathfinder(const Grid & grid);
+
+    // re-read walls from the grid, which must be the same size as before
+    void update_walls(const Grid & grid);
+
+    // find a shortest path from start to goal. On success, path holds every
+    // cell along it, start & goal included. Returns false, with an empty path,
+    // if goal can't be reached. Throws std::out_of_range if either cell is off
+    // the grid
+    bool find_path(const sf::Vector2u & start, const sf::Vector2u & goal,
+        std::vector<sf::Vector2u> & path, const Method method = JUMP_POINT);
+
+    // cells taken off the open list by the last query
+    std::size_t num_expanded() const;
+
+    unsigned int width() const;
+    unsigned int height() const;
+
+private:
+    typedef std::uint32_t Cell;
+    static const Cell no_cell = 0xFFFFFFFF;
+
+    struct Open_entry
+    {
+        std::uint32_t f; // cost so far + estimate to goal
+        std::uint32_t h; // estimate to goal, to break ties toward the goal
+        Cell cell;
+    };
+
+    void begin_query();
+    bool seen(const Cell cell) const;
+    bool closed(const Cell cell) const;
+    void relax(const Cell cell, const Cell parent, const std::uint32_t g);
+    void push_open(const Cell cell, const std::uint32_t g);
+    Cell pop_open();
+
+    bool search_a_star();
+    bool search_jump_point();
+    void expand_jump_point(const Cell cell);
+    Cell jump_horiz(Cell cell, const Direction dir) const;
+    Cell jump_vert(Cell cell, const Direction dir) const;
+
+    std::uint32_t estimate(const Cell cell) const;
+    bool open(const Cell cell, const Direction dir) const;
+    Cell step(const Cell cell, const Direction dir) const;
+
+    unsigned int _width, _height;
+    Cell _goal = 0;
+
+    // bit (1 << Direction) is set for each side of a cell without a wall
+    std::vector<std::uint8_t> _open_sides;
+
+    // per-query state. A cell's g & parent are only valid while its stamp is
+    // _generation (on the open list) or _generation + 1 (closed)
+    std::vector<std::uint32_t> _stamp;
+    std::vector<std::uint32_t> _g;
+    std::vector<Cell> _parent;
+    std::uint32_t _generation = 0;
+
+    std::vector<Open_entry> _open_list; // binary min-heap
+    std::size_t _num_expanded = 0;
+};
+
+inline std::size_t Pathfinder::num_expanded() const
+{
+    return _num_expanded;
+}
+
+inline unsigned int Pathfinder::width() const
+{
+    return _width;
+}
+
+inline unsigned int Pathfinder::height() const
+{
+    return _height;
+}
+
+#endif // PATHFIND_HPP
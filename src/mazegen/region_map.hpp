@@ -0,0 +1,136 @@
+// region_map.hpp
+// per-cell region ids, 16 bits a cell until more are needed
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef REGION_MAP_HPP
+#define REGION_MAP_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// region id of each cell. Ids are held in 16 bits while every id stored fits,
+// and the whole map is widened to 32 bits the first time one doesn't. Small &
+// medium grids have far fewer than 32768 regions, so they never widen
+class Region_map final
+{
+public:
+    void assign(const std::size_t size, const int val);
+    // free all storage. get & set mustn't be called until the next assign
+    void clear();
+    bool empty() const;
+
+    int get(const std::size_t i) const;
+    // widens the map if val doesn't fit, which isn't safe alongside any
+    // other access. Use reserve first to set from several threads
+    void set(const std::size_t i, const int val);
+    void fill(const std::size_t begin, const std::size_t end, const int val);
+
+    // true if val can be set without widening
+    bool fits(const int val) const;
+    // widen now if any of [min_val, max_val] doesn't fit
+    void reserve(const int min_val, const int max_val);
+
+    // the ids as 32-bit ints, or null while they're held in 16 bits
+    const int * wide_data() const;
+
+private:
+    void widen();
+
+    bool _wide = false;
+    std::vector<std::int16_t> _narrow;
+    std::vector<int> _wide_ids;
+};
+
+inline void Region_map::assign(const std::size_t size, const int val)
+{
+    _wide = false;
+    _wide_ids.clear();
+    _wide_ids.shrink_to_fit();
+    _narrow.assign(size, 0);
+    fill(0, size, val);
+}
+
+inline void Region_map::clear()
+{
+    _wide = false;
+    std::vector<std::int16_t>().swap(_narrow);
+    std::vector<int>().swap(_wide_ids);
+}
+
+inline bool Region_map::empty() const
+{
+    return _narrow.empty() && _wide_ids.empty();
+}
+
+inline int Region_map::get(const std::size_t i) const
+{
+    return _wide ? _wide_ids[i] : _narrow[i];
+}
+
+inline void Region_map::set(const std::size_t i, const int val)
+{
+    if(!fits(val))
+        widen();
+
+    if(_wide)
+        _wide_ids[i] = val;
+    else
+        _narrow[i] = (std::int16_t)val;
+}
+
+inline void Region_map::fill(const std::size_t begin, const std::size_t end, const int val)
+{
+    if(!fits(val))
+        widen();
+
+    if(_wide)
+        std::fill(_wide_ids.begin() + begin, _wide_ids.begin() + end, val);
+    else
+        std::fill(_narrow.begin() + begin, _narrow.begin() + end, (std::int16_t)val);
+}
+
+inline bool Region_map::fits(const int val) const
+{
+    return _wide || (val >= INT16_MIN && val <= INT16_MAX);
+}
+
+inline void Region_map::reserve(const int min_val, const int max_val)
+{
+    if(!fits(min_val) || !fits(max_val))
+        widen();
+}
+
+inline const int * Region_map::wide_data() const
+{
+    return _wide ? _wide_ids.data() : nullptr;
+}
+
+inline void Region_map::widen()
+{
+    _wide_ids.assign(_narrow.begin(), _narrow.end());
+    _narrow.clear();
+    _narrow.shrink_to_fit();
+    _wide = true;
+}
+
+#endif // REGION_MAP_HPP
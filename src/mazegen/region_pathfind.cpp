@@ -0,0 +1,897 @@
+// region_pathfind.cpp
+// hierarchical shortest paths over grid regions
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "mazegen/region_pathfind.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "util/parallel.hpp"
+
+namespace
+{
+    // ordering for the open list heap: lowest f on top, ties to the lowest h
+    template<typename Entry>
+    bool worse_entry(const Entry & a, const Entry & b)
+    {
+        return a.f > b.f || (a.f == b.f && a.h > b.h);
+    }
+
+    template<typename T>
+    T abs_diff(const T a, const T b)
+    {
+        return a > b ? a - b : b - a;
+    }
+
+    // UP & DOWN, and LEFT & RIGHT, are adjacent in Direction
+    Direction opposite(const Direction dir)
+    {
+        return (Direction)(dir ^ 1);
+    }
+
+    // index of the highest set bit of val, which must not be 0
+    unsigned int highest_bit(const unsigned int val)
+    {
+        return 31 - __builtin_clz(val);
+    }
+
+    void check_endpoints(const sf::Vector2u & start, const sf::Vector2u & goal,
+        const unsigned int width, const unsigned int height)
+    {
+        if(start.x >= width || start.y >= height || goal.x >= width || goal.y >= height)
+        {
+            throw std::out_of_range("path endpoint off grid: (" +
+                std::to_string(start.x) + ", " + std::to_string(start.y) + ") to (" +
+                std::to_string(goal.x) + ", " + std::to_string(goal.y) + ")");
+        }
+    }
+}
+
+Region_pathfinder::Region_pathfinder(const Grid & grid, const unsigned int cluster_size,
+    const unsigned int num_threads):
+    _width(grid.width()), _height(grid.height()), _cluster_size(cluster_size)
+{
+    if((std::uint64_t)_width * _height >= no_node - 2)
+    {
+        throw std::invalid_argument("grid too large for pathfinding: " +
+            std::to_string(_width) + "x" + std::to_string(_height));
+    }
+    if(cluster_size < 2 || cluster_size > 256)
+        throw std::invalid_argument("cluster size out of range: " + std::to_string(cluster_size));
+    if(!grid.has_regions())
+        throw std::invalid_argument("grid's regions have been dropped");
+
+    _sectors_x = (_width + _cluster_size - 1) / _cluster_size;
+    _sectors_y = (_height + _cluster_size - 1) / _cluster_size;
+
+    // split open sides into those within a cluster, and those between
+    std::size_t size = (std::size_t)_width * _height;
+    grid.open_sides(_local_sides);
+    std::vector<std::uint8_t> cross_sides(size, 0);
+
+    parallel_for(_sectors_y, [this, &grid, &cross_sides](const std::size_t sector_y)
+    {
+        unsigned int y_end = std::min(_height, (unsigned int)(sector_y + 1) * _cluster_size);
+        for(unsigned int y = sector_y * _cluster_size; y < y_end; ++y)
+        {
+            for(unsigned int x = 0; x < _width; ++x)
+            {
+                Cell cell = y * _width + x;
+                for(Direction dir: {UP, DOWN, LEFT, RIGHT})
+                {
+                    if(!open(cell, dir))
+                        continue;
+
+                    Cell neighbor = step(cell, dir);
+                    unsigned int nx = neighbor % _width, ny = neighbor / _width;
+                    if(sector(neighbor) != sector(cell) || grid.region(nx, ny) != grid.region(x, y))
+                    {
+                        _local_sides[cell] &= ~(1 << dir);
+                        cross_sides[cell] |= 1 << dir;
+                    }
+                }
+            }
+        }
+    }, num_threads);
+
+    // find each row of sectors' nodes & the distances between them
+    std::vector<std::vector<Cell>> row_nodes(_sectors_y);
+    std::vector<std::vector<Node>> row_sector_counts(_sectors_y);
+    std::vector<std::vector<Edge>> row_intra_edges(_sectors_y);
+    std::vector<std::vector<std::uint32_t>> row_intra_counts(_sectors_y);
+
+    parallel_for(_sectors_y, [&](const std::size_t sector_y)
+    {
+        build_sector_row(sector_y, cross_sides, row_nodes[sector_y], row_sector_counts[sector_y],
+            row_intra_edges[sector_y], row_intra_counts[sector_y]);
+    }, num_threads);
+
+    // number the nodes, then lay out each one's edges: those within its
+    // cluster, then one across each wall to another cluster
+    _sector_first.reserve((std::size_t)_sectors_x * _sectors_y + 1);
+    _sector_first.push_back(0);
+    for(unsigned int sector_y = 0; sector_y < _sectors_y; ++sector_y)
+    {
+        for(const auto count: row_sector_counts[sector_y])
+            _sector_first.push_back(_sector_first.back() + count);
+        _node_cell.insert(_node_cell.end(), row_nodes[sector_y].begin(), row_nodes[sector_y].end());
+    }
+
+    std::size_t num_nodes = _node_cell.size();
+    _edge_first.resize(num_nodes + 1);
+    _edge_first[0] = 0;
+    Node node = 0;
+    for(unsigned int sector_y = 0; sector_y < _sectors_y; ++sector_y)
+    {
+        for(const auto count: row_intra_counts[sector_y])
+        {
+            std::size_t num_cross = 0;
+            for(std::uint8_t sides = cross_sides[_node_cell[node]]; sides; sides &= sides - 1)
+                ++num_cross;
+
+            _edge_first[node + 1] = _edge_first[node] + count + num_cross;
+            ++node;
+        }
+    }
+    _edges.resize(_edge_first[num_nodes]);
+
+    parallel_for(_sectors_y, [&](const std::size_t sector_y)
+    {
+        const Edge * intra = row_intra_edges[sector_y].data();
+        const std::uint32_t * intra_count = row_intra_counts[sector_y].data();
+
+        for(unsigned int sector_x = 0; sector_x < _sectors_x; ++sector_x)
+        {
+            std::size_t sector = sector_y * _sectors_x + sector_x;
+            for(Node node = _sector_first[sector]; node < _sector_first[sector + 1]; ++node)
+            {
+                Edge * edge = &_edges[_edge_first[node]];
+                for(std::uint32_t i = 0; i < *intra_count; ++i, ++intra)
+                {
+                    Node to = _sector_first[sector] + intra->to;
+                    *edge++ = {to, _node_cell[to], intra->cost};
+                }
+                ++intra_count;
+
+                Cell cell = _node_cell[node];
+                for(Direction dir: {UP, DOWN, LEFT, RIGHT})
+                {
+                    if(cross_sides[cell] & (1 << dir))
+                        *edge++ = {find_node(step(cell, dir)), step(cell, dir), 1};
+                }
+            }
+        }
+
+        std::vector<Edge>().swap(row_intra_edges[sector_y]);
+    }, num_threads);
+
+    // add levels of squares until one covers every sector, or they'd be too big
+    while(((_sectors_x - 1) | (_sectors_y - 1)) >> (_num_levels * level_bits) &&
+        (std::uint64_t)_cluster_size << (_num_levels * level_bits) <= max_square_size)
+    {
+        ++_num_levels;
+    }
+
+    _node_cross.resize(num_nodes);
+    _cross_levels.resize(num_nodes);
+    _node_sector_y.resize(num_nodes);
+    _node_level.resize(num_nodes);
+    _clique_base.resize(num_nodes + 1);
+    _clique_base[0] = 0;
+    for(Node node = 0; node < num_nodes; ++node)
+    {
+        Cell cell = _node_cell[node];
+        _node_cross[node] = cross_sides[cell];
+        _cross_levels[node] = 0;
+        _node_sector_y[node] = cell / _width / _cluster_size;
+
+        unsigned int level = 1;
+        for(Direction dir: {UP, DOWN, LEFT, RIGHT})
+        {
+            if(cross_sides[cell] & (1 << dir))
+            {
+                unsigned int dir_level = cross_level(cell, dir);
+                _cross_levels[node] |= dir_level << (8 * dir);
+                level = std::max(level, dir_level);
+            }
+        }
+        _node_level[node] = level;
+        _clique_base[node + 1] = _clique_base[node] + level - 1;
+    }
+    std::vector<std::uint8_t>().swap(cross_sides);
+
+    // each level's edges are found from the one below
+    _clique_ranges.resize(_clique_base[num_nodes]);
+    _clique_edges.resize(_num_levels - 1);
+    for(unsigned int level = 2; level <= _num_levels; ++level)
+    {
+        unsigned int squares_y = ((_sectors_y - 1) >> ((level - 1) * level_bits)) + 1;
+        std::vector<std::vector<Edge>> row_edges(squares_y);
+        std::vector<std::vector<std::pair<Node, std::uint32_t>>> row_counts(squares_y);
+
+        parallel_for(squares_y, [&](const std::size_t square_y)
+        {
+            build_square_row(level, square_y, row_edges[square_y], row_counts[square_y]);
+        }, num_threads);
+
+        std::vector<Edge> & edges = _clique_edges[level - 2];
+        for(unsigned int square_y = 0; square_y < squares_y; ++square_y)
+        {
+            std::size_t first = edges.size();
+            for(const auto & count: row_counts[square_y])
+            {
+                _clique_ranges[_clique_base[count.first] + level - 2] = {first, count.second};
+                first += count.second;
+            }
+            edges.insert(edges.end(), row_edges[square_y].begin(), row_edges[square_y].end());
+            std::vector<Edge>().swap(row_edges[square_y]);
+        }
+    }
+
+    _route_cache.resize(_num_levels);
+
+    _start_node = num_nodes;
+    _goal_node = num_nodes + 1;
+    _search_nodes.assign(num_nodes + 2, {0, 0, 0});
+
+    init_local_search(_start_search);
+    init_local_search(_goal_search);
+}
+
+bool Region_pathfinder::find_path(const sf::Vector2u & start, const sf::Vector2u & goal,
+    std::vector<sf::Vector2u> & path)
+{
+    path.clear();
+    check_endpoints(start, goal, _width, _height);
+
+    if(!search_abstract(start, goal))
+        return false;
+
+    _route.clear();
+    for(Node node = _goal_node; node != _start_node; node = _search_nodes[node].parent)
+        _route.push_back(node);
+    std::reverse(_route.begin(), _route.end());
+
+    // fill in each step of the route. The first & last are already known from
+    // the searches around the endpoints. The rest are filled in at the level
+    // they were searched at
+    path.reserve(_search_nodes[_goal_node].g + 1);
+    path.push_back(start);
+    Node prev = _start_node;
+    for(const auto node: _route)
+    {
+        if(prev == _start_node)
+            append_from_root(_start_search, node == _goal_node ? _goal : _node_cell[node], path);
+        else if(node == _goal_node)
+        {
+            // the goal's search leads back toward the goal
+            Cell prev_cell = _node_cell[prev];
+            for(std::uint8_t dir = _goal_search.back_dir[local_index(prev_cell)]; dir != no_dir;
+                dir = _goal_search.back_dir[local_index(prev_cell)])
+            {
+                prev_cell = step(prev_cell, (Direction)dir);
+                path.push_back(sf::Vector2u(prev_cell % _width, prev_cell / _width));
+            }
+        }
+        else
+            append_edge(search_level(prev), prev, node, path);
+
+        prev = node;
+    }
+
+    return true;
+}
+
+std::uint32_t Region_pathfinder::distance(const sf::Vector2u & start, const sf::Vector2u & goal)
+{
+    check_endpoints(start, goal, _width, _height);
+    return search_abstract(start, goal) ? _search_nodes[_goal_node].g : unreachable;
+}
+
+void Region_pathfinder::init_local_search(Local_search & search) const
+{
+    std::size_t size = (std::size_t)_cluster_size * _cluster_size;
+    search.stamp.assign(size, 0);
+    search.dist.resize(size);
+    search.back_dir.resize(size);
+    search.queue.reserve(size);
+}
+
+// breadth-first search from root, over its cluster, until stop is reached
+// (if it's in the cluster)
+void Region_pathfinder::search_local(Local_search & search, const Cell root, const Cell stop) const
+{
+    if(search.generation == std::numeric_limits<std::uint32_t>::max())
+    {
+        std::fill(search.stamp.begin(), search.stamp.end(), 0);
+        search.generation = 0;
+    }
+    ++search.generation;
+
+    unsigned int x = root % _width, y = root / _width;
+    search.origin = (y - y % _cluster_size) * _width + (x - x % _cluster_size);
+
+    std::uint32_t root_index = local_index(root);
+    search.stamp[root_index] = search.generation;
+    search.dist[root_index] = 0;
+    search.back_dir[root_index] = no_dir;
+    search.queue.clear();
+    search.queue.emplace_back(root, root_index);
+
+    for(std::size_t i = 0; i < search.queue.size(); ++i)
+    {
+        Cell cell = search.queue[i].first;
+        std::uint32_t index = search.queue[i].second;
+        if(cell == stop)
+            break;
+
+        for(Direction dir: {UP, DOWN, LEFT, RIGHT})
+        {
+            if(!open(cell, dir))
+                continue;
+
+            std::uint32_t neighbor_index = dir == UP ? index - _cluster_size :
+                dir == DOWN ? index + _cluster_size : dir == LEFT ? index - 1 : index + 1;
+            if(search.stamp[neighbor_index] == search.generation)
+                continue;
+
+            search.stamp[neighbor_index] = search.generation;
+            search.dist[neighbor_index] = search.dist[index] + 1;
+            search.back_dir[neighbor_index] = opposite(dir);
+            search.queue.emplace_back(step(cell, dir), neighbor_index);
+        }
+    }
+}
+
+// cell must be in the sector last searched
+inline bool Region_pathfinder::reached(const Local_search & search, const Cell cell) const
+{
+    return search.stamp[local_index(cell)] == search.generation;
+}
+
+inline std::uint32_t Region_pathfinder::local_dist(const Local_search & search, const Cell cell) const
+{
+    return search.dist[local_index(cell)];
+}
+
+// nodes of each sector in a row are the cells with an open wall to another
+// cluster, in order. Each is linked to the others it can reach in its sector,
+// by sector-relative node number, unless another node is on the way
+void Region_pathfinder::build_sector_row(const unsigned int sector_y, const std::vector<std::uint8_t> & cross_sides,
+    std::vector<Cell> & nodes, std::vector<Node> & sector_counts,
+    std::vector<Edge> & intra_edges, std::vector<std::uint32_t> & intra_counts) const
+{
+    Local_search search;
+    init_local_search(search);
+    std::vector<std::uint32_t> dist;
+
+    unsigned int y_begin = sector_y * _cluster_size;
+    unsigned int y_end = std::min(_height, y_begin + _cluster_size);
+
+    for(unsigned int sector_x = 0; sector_x < _sectors_x; ++sector_x)
+    {
+        unsigned int x_begin = sector_x * _cluster_size;
+        unsigned int x_end = std::min(_width, x_begin + _cluster_size);
+
+        std::size_t first = nodes.size();
+        for(unsigned int y = y_begin; y < y_end; ++y)
+        {
+            for(unsigned int x = x_begin; x < x_end; ++x)
+            {
+                if(cross_sides[y * _width + x])
+                    nodes.push_back(y * _width + x);
+            }
+        }
+        sector_counts.push_back(nodes.size() - first);
+
+        // distances between every pair of the sector's nodes
+        std::size_t num_nodes = nodes.size() - first;
+        dist.resize(num_nodes * num_nodes);
+        for(std::size_t i = 0; i < num_nodes; ++i)
+        {
+            search_local(search, nodes[first + i], no_node);
+            for(std::size_t j = 0; j < num_nodes; ++j)
+                dist[i * num_nodes + j] = reached(search, nodes[first + j]) ? local_dist(search, nodes[first + j]) : unreachable;
+        }
+
+        // skip edges that are no shorter than going by way of another node.
+        // In a maze, most paths between 2 nodes pass others, so this leaves
+        // few edges per node without changing any distance
+        for(std::size_t i = 0; i < num_nodes; ++i)
+        {
+            std::uint32_t count = 0;
+            for(std::size_t j = 0; j < num_nodes; ++j)
+            {
+                std::uint32_t dist_ij = dist[i * num_nodes + j];
+                if(j == i || dist_ij == unreachable)
+                    continue;
+
+                bool redundant = false;
+                for(std::size_t k = 0; k < num_nodes && !redundant; ++k)
+                {
+                    redundant = k != i && k != j && dist[i * num_nodes + k] != unreachable &&
+                        dist[i * num_nodes + k] + dist[k * num_nodes + j] == dist_ij;
+                }
+
+                if(!redundant)
+                {
+                    intra_edges.push_back({(Node)j, nodes[first + j], dist_ij});
+                    ++count;
+                }
+            }
+            intra_counts.push_back(count);
+        }
+    }
+}
+
+// A* over the abstract graph, from a node for start linked to the nodes of its
+// cluster, to one for goal linked likewise
+bool Region_pathfinder::search_abstract(const sf::Vector2u & start, const sf::Vector2u & goal)
+{
+    _num_expanded = 0;
+    _open_list.clear();
+    if(_generation >= std::numeric_limits<std::uint32_t>::max() - 2)
+    {
+        for(auto & node: _search_nodes)
+            node.stamp = 0;
+        _generation = 0;
+    }
+    _generation += 2;
+
+    Cell start_cell = start.y * _width + start.x;
+    _goal = goal.y * _width + goal.x;
+    _start_sector_x = start.x / _cluster_size;
+    _start_sector_y = start.y / _cluster_size;
+    _goal_sector_x = goal.x / _cluster_size;
+    _goal_sector_y = goal.y / _cluster_size;
+
+    search_local(_start_search, start_cell, no_node);
+    search_local(_goal_search, _goal, no_node);
+
+    _search_nodes[_start_node] = {_generation + 1, 0, _start_node};
+
+    unsigned int start_sector = sector(start_cell);
+    for(Node node = _sector_first[start_sector]; node < _sector_first[start_sector + 1]; ++node)
+    {
+        if(reached(_start_search, _node_cell[node]))
+            relax(node, _node_cell[node], _start_node, local_dist(_start_search, _node_cell[node]));
+    }
+    if(sector(_goal) == start_sector && reached(_start_search, _goal))
+        relax(_goal_node, _goal, _start_node, local_dist(_start_search, _goal));
+
+    unsigned int goal_sector = sector(_goal);
+    Node goal_first = _sector_first[goal_sector], goal_last = _sector_first[goal_sector + 1];
+
+    for(Node node = pop_open(); node != no_node; node = pop_open())
+    {
+        if(node == _goal_node)
+            return true;
+
+        std::uint32_t g = _search_nodes[node].g;
+        for_each_edge(node, search_level(node), _num_levels, [this, node, g](const Edge & edge)
+        {
+            relax(edge.to, edge.cell, node, g + edge.cost);
+        });
+
+        if(node >= goal_first && node < goal_last && reached(_goal_search, _node_cell[node]))
+            relax(_goal_node, _goal, node, g + local_dist(_goal_search, _node_cell[node]));
+    }
+    return false;
+}
+
+// each node of a row of squares at level, with an edge to each other node of
+// its square it can reach within it, unless another node is on the way
+void Region_pathfinder::build_square_row(const unsigned int level, const unsigned int square_y,
+    std::vector<Edge> & edges, std::vector<std::pair<Node, std::uint32_t>> & counts) const
+{
+    Square_search search;
+    std::vector<Node> square_nodes;
+
+    unsigned int squares_x = ((_sectors_x - 1) >> ((level - 1) * level_bits)) + 1;
+    for(unsigned int square_x = 0; square_x < squares_x; ++square_x)
+    {
+        init_square(search, level, square_x, square_y);
+
+        square_nodes.clear();
+        for(std::size_t row = 0; row < search.row_first.size(); ++row)
+        {
+            Node row_end = search.row_first[row] + (search.row_offset[row + 1] - search.row_offset[row]);
+            for(Node node = search.row_first[row]; node < row_end; ++node)
+            {
+                if(_node_level[node] >= level)
+                    square_nodes.push_back(node);
+            }
+        }
+
+        for(const auto node: square_nodes)
+        {
+            search.targets_left = square_nodes.size();
+            search_square(search, node, no_node);
+
+            std::uint32_t count = 0;
+            for(const auto to: square_nodes)
+            {
+                std::uint32_t index = square_index(search, to);
+                if(to != node && search.stamp[index] == search.generation + 1 && !search.via[index])
+                {
+                    edges.push_back({to, _node_cell[to], search.dist[index]});
+                    ++count;
+                }
+            }
+            counts.emplace_back(node, count);
+        }
+    }
+}
+
+// set search up for the square at (square_x, square_y) of level
+void Region_pathfinder::init_square(Square_search & search, const unsigned int level,
+    const unsigned int square_x, const unsigned int square_y) const
+{
+    unsigned int span_bits = (level - 1) * level_bits;
+    unsigned int x_begin = square_x << span_bits, x_end = std::min(_sectors_x, (square_x + 1) << span_bits);
+    unsigned int y_begin = square_y << span_bits, y_end = std::min(_sectors_y, (square_y + 1) << span_bits);
+
+    search.level = level;
+    search.sector_y = y_begin;
+    search.row_first.clear();
+    search.row_offset.assign(1, 0);
+    for(unsigned int y = y_begin; y < y_end; ++y)
+    {
+        Node first = _sector_first[y * _sectors_x + x_begin];
+        search.row_first.push_back(first);
+        search.row_offset.push_back(search.row_offset.back() + (_sector_first[y * _sectors_x + x_end] - first));
+    }
+
+    std::size_t size = search.row_offset.back();
+    if(search.stamp.size() < size)
+    {
+        search.stamp.resize(size, 0);
+        search.dist.resize(size);
+        search.parent.resize(size);
+        search.via.resize(size);
+    }
+}
+
+// Dijkstra's algorithm from source, over the edges of the level below the
+// square's, within the square. With a target, stops once it's reached, and
+// heads toward it as A* does. Without, stops once targets_left of the
+// square's level's nodes are reached
+void Region_pathfinder::search_square(Square_search & search, const Node source, const Node target) const
+{
+    if(search.generation >= std::numeric_limits<std::uint32_t>::max() - 2)
+    {
+        std::fill(search.stamp.begin(), search.stamp.end(), 0);
+        search.generation = 0;
+    }
+    search.generation += 2;
+    search.open_list.clear();
+
+    Cell target_cell = target == no_node ? 0 : _node_cell[target];
+    auto estimate = [this, target, target_cell](const Cell cell) -> std::uint32_t
+    {
+        if(target == no_node)
+            return 0;
+        return abs_diff(cell % _width, target_cell % _width) + abs_diff(cell / _width, target_cell / _width);
+    };
+
+    std::uint32_t index = square_index(search, source);
+    search.stamp[index] = search.generation;
+    search.dist[index] = 0;
+    search.parent[index] = source;
+    search.via[index] = false;
+    std::uint32_t h = estimate(_node_cell[source]);
+    search.open_list.push_back({h, h, source});
+
+    while(!search.open_list.empty())
+    {
+        std::pop_heap(search.open_list.begin(), search.open_list.end(), worse_entry<Open_entry>);
+        Node node = search.open_list.back().node;
+        search.open_list.pop_back();
+
+        index = square_index(search, node);
+        if(search.stamp[index] == search.generation + 1)
+            continue;
+        search.stamp[index] = search.generation + 1;
+        if(node == target)
+            return;
+        if(target == no_node && _node_level[node] >= search.level && --search.targets_left == 0)
+            return;
+
+        std::uint32_t dist = search.dist[index];
+        bool via = search.via[index] || (node != source && _node_level[node] >= search.level);
+        for_each_edge(node, search.level - 1, search.level - 1, [&](const Edge & edge)
+        {
+            std::uint32_t to_index = square_index(search, edge.to);
+            std::uint32_t to_dist = dist + edge.cost;
+            if(search.stamp[to_index] == search.generation + 1)
+                return;
+            if(search.stamp[to_index] == search.generation && to_dist >= search.dist[to_index])
+            {
+                // an equally short way past another node makes the edge redundant too
+                if(to_dist == search.dist[to_index])
+                    search.via[to_index] |= via;
+                return;
+            }
+
+            search.stamp[to_index] = search.generation;
+            search.dist[to_index] = to_dist;
+            search.parent[to_index] = node;
+            search.via[to_index] = via;
+            std::uint32_t to_h = estimate(edge.cell);
+            search.open_list.push_back({to_dist + to_h, to_h, edge.to});
+            std::push_heap(search.open_list.begin(), search.open_list.end(), worse_entry<Open_entry>);
+        });
+    }
+}
+
+// position of node among its square's. It must be in the square last set up
+inline std::uint32_t Region_pathfinder::square_index(const Square_search & search, const Node node) const
+{
+    unsigned int row = _node_sector_y[node] - search.sector_y;
+    return search.row_offset[row] + (node - search.row_first[row]);
+}
+
+// calls func with each edge of node at level: those within its cluster at
+// level 1, or its square above that, then those across walls out of it, up
+// to max_cross_level
+template<typename Func>
+void Region_pathfinder::for_each_edge(const Node node, const unsigned int level,
+    const unsigned int max_cross_level, Func func) const
+{
+    std::uint8_t cross = _node_cross[node];
+    std::size_t cross_first = _edge_first[node + 1] - count_bits(cross);
+
+    if(level == 1)
+    {
+        for(std::size_t i = _edge_first[node]; i < cross_first; ++i)
+            func(_edges[i]);
+    }
+    else
+    {
+        const Clique_range & range = _clique_ranges[_clique_base[node] + level - 2];
+        const Edge * edges = _clique_edges[level - 2].data() + range.first;
+        for(std::uint32_t i = 0; i < range.count; ++i)
+            func(edges[i]);
+    }
+
+    std::size_t i = cross_first;
+    for(std::uint32_t levels = _cross_levels[node]; levels; levels >>= 8)
+    {
+        unsigned int edge_level = levels & 0xFF;
+        if(edge_level == 0)
+            continue;
+
+        if(edge_level >= level && edge_level <= max_cross_level)
+            func(_edges[i]);
+        ++i;
+    }
+}
+
+// highest level whose squares differ between 2 sectors, given the XOR of
+// their coordinates, or 1 if none do
+inline unsigned int Region_pathfinder::level_apart(const unsigned int sector_diff) const
+{
+    if(sector_diff == 0)
+        return 1;
+    return std::min(_num_levels, highest_bit(sector_diff) / level_bits + 1);
+}
+
+// highest level whose squares cell & its neighbor across dir are in different
+// ones, or 1 if only their clusters differ
+inline unsigned int Region_pathfinder::cross_level(const Cell cell, const Direction dir) const
+{
+    unsigned int from = 0, to = 0;
+    switch(dir)
+    {
+    case UP:
+    case DOWN:
+        from = cell / _width;
+        to = dir == UP ? from - 1 : from + 1;
+        break;
+    case LEFT:
+    case RIGHT:
+        from = cell % _width;
+        to = dir == LEFT ? from - 1 : from + 1;
+        break;
+    }
+    return level_apart(from / _cluster_size ^ to / _cluster_size);
+}
+
+// level to search node's edges at: the highest whose square holds neither
+// endpoint, or 1 near them
+inline unsigned int Region_pathfinder::search_level(const Node node) const
+{
+    Cell cell = _node_cell[node];
+    unsigned int x = cell % _width / _cluster_size, y = cell / _width / _cluster_size;
+    return std::min(level_apart((x ^ _start_sector_x) | (y ^ _start_sector_y)),
+        level_apart((x ^ _goal_sector_x) | (y ^ _goal_sector_y)));
+}
+
+// append the cells after from, up to & including to, along the edge between
+// them at level: a shortest path within their cluster at level 1, or their
+// square above that, filled in from the level below. Routes are cached
+void Region_pathfinder::append_edge(const unsigned int level, const Node from, const Node to,
+    std::vector<sf::Vector2u> & path)
+{
+    Cell from_cell = _node_cell[from], to_cell = _node_cell[to];
+    for(Direction dir: {UP, DOWN, LEFT, RIGHT})
+    {
+        if(((_local_sides[from_cell] | _node_cross[from]) & (1 << dir)) && step(from_cell, dir) == to_cell)
+        {
+            path.push_back(sf::Vector2u(to_cell % _width, to_cell / _width));
+            return;
+        }
+    }
+
+    auto & routes = _route_cache[level - 1];
+    std::uint64_t key = (std::uint64_t)from << 32 | to;
+    auto found = routes.find(key);
+    if(found == routes.end())
+    {
+        std::vector<std::uint32_t> route;
+        if(level == 1)
+        {
+            // the start's search is done with, so can be reused
+            search_local(_start_search, from_cell, to_cell);
+            for(Cell at = to_cell; at != from_cell; at = step(at, (Direction)_start_search.back_dir[local_index(at)]))
+                route.push_back(at);
+        }
+        else
+        {
+            unsigned int span_bits = (level - 1) * level_bits;
+            init_square(_route_search, level, from_cell % _width / _cluster_size >> span_bits,
+                _node_sector_y[from] >> span_bits);
+            search_square(_route_search, from, to);
+            for(Node at = to; at != from; at = _route_search.parent[square_index(_route_search, at)])
+                route.push_back(at);
+        }
+        std::reverse(route.begin(), route.end());
+
+        if(_route_cache_size + route.size() > route_cache_limit)
+        {
+            for(auto & level_routes: _route_cache)
+                level_routes.clear();
+            _route_cache_size = 0;
+        }
+        _route_cache_size += route.size();
+        found = _route_cache[level - 1].emplace(key, std::move(route)).first;
+    }
+
+    if(level == 1)
+    {
+        for(const auto cell: found->second)
+            path.push_back(sf::Vector2u(cell % _width, cell / _width));
+        return;
+    }
+
+    // filling in the level below may add to the cache, so copy the route first
+    std::vector<std::uint32_t> route = found->second;
+    Node prev = from;
+    for(const auto node: route)
+    {
+        append_edge(level - 1, prev, node, path);
+        prev = node;
+    }
+}
+
+// append the cells on the way from search's root to cell, which it reached,
+// root excluded
+void Region_pathfinder::append_from_root(const Local_search & search, const Cell cell,
+    std::vector<sf::Vector2u> & path) const
+{
+    std::size_t begin = path.size();
+    Cell at = cell;
+    for(std::uint8_t dir = search.back_dir[local_index(at)]; dir != no_dir; dir = search.back_dir[local_index(at)])
+    {
+        path.push_back(sf::Vector2u(at % _width, at / _width));
+        at = step(at, (Direction)dir);
+    }
+    std::reverse(path.begin() + begin, path.end());
+}
+
+// record a path to node (at cell) through parent, if it's shorter than any
+// found so far. A node may be pushed again when a shorter path to it is found.
+// The stale entry is skipped when popped, as the node is closed by then
+inline void Region_pathfinder::relax(const Node node, const Cell cell, const Node parent, const std::uint32_t g)
+{
+    Search_node & search_node = _search_nodes[node];
+    bool seen = search_node.stamp - _generation <= 1;
+    if(seen && (search_node.stamp == _generation + 1 || g >= search_node.g))
+        return;
+
+    search_node = {_generation, g, parent};
+
+    std::uint32_t h = estimate(cell);
+    _open_list.push_back({g + h, h, node});
+    std::push_heap(_open_list.begin(), _open_list.end(), worse_entry<Open_entry>);
+}
+
+// returns no_node when the open list runs out
+inline Region_pathfinder::Node Region_pathfinder::pop_open()
+{
+    while(!_open_list.empty())
+    {
+        std::pop_heap(_open_list.begin(), _open_list.end(), worse_entry<Open_entry>);
+        Node node = _open_list.back().node;
+        _open_list.pop_back();
+
+        if(_search_nodes[node].stamp != _generation + 1)
+        {
+            _search_nodes[node].stamp = _generation + 1;
+            ++_num_expanded;
+            return node;
+        }
+    }
+    return no_node;
+}
+
+inline unsigned int Region_pathfinder::sector(const Cell cell) const
+{
+    return (cell / _width / _cluster_size) * _sectors_x + (cell % _width) / _cluster_size;
+}
+
+// position of a cell within its sector
+inline std::uint32_t Region_pathfinder::local_index(const Cell cell) const
+{
+    return (cell / _width % _cluster_size) * _cluster_size + cell % _width % _cluster_size;
+}
+
+// node at cell, which must be one
+Region_pathfinder::Node Region_pathfinder::find_node(const Cell cell) const
+{
+    unsigned int cell_sector = sector(cell);
+    auto first = _node_cell.begin() + _sector_first[cell_sector];
+    auto last = _node_cell.begin() + _sector_first[cell_sector + 1];
+    return std::lower_bound(first, last, cell) - _node_cell.begin();
+}
+
+// Manhattan distance to the goal. Never overestimates on a 4-connected grid
+inline std::uint32_t Region_pathfinder::estimate(const Cell cell) const
+{
+    return abs_diff(cell % _width, _goal % _width) + abs_diff(cell / _width, _goal / _width);
+}
+
+inline bool Region_pathfinder::open(const Cell cell, const Direction dir) const
+{
+    return _local_sides[cell] & (1 << dir);
+}
+
+// neighbor of cell, which must be open on that side
+inline Region_pathfinder::Cell Region_pathfinder::step(const Cell cell, const Direction dir) const
+{
+    switch(dir)
+    {
+    case UP:
+        return cell - _width;
+    case DOWN:
+        return cell + _width;
+    case LEFT:
+        return cell - 1;
+    case RIGHT:
+    default:
+        return cell + 1;
+    }
+}
@@ -0,0 +1,286 @@
+// region_pathfind.hpp
+// hierarchical shortest paths over grid regions
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef REGION_PATHFIND_HPP
+#define REGION_PATHFIND_HPP
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <SFML/System.hpp>
+
+#include "mazegen/grid.hpp"
+
+// finds shortest paths between cells of a grid by way of its regions (rooms &
+// maze patches). Regions are cut into clusters no bigger than a sector of
+// cluster_size x cluster_size cells, and every cell with an open wall to
+// another cluster becomes a node of an abstract graph. Nodes of one cluster
+// are linked by their shortest distance within it, and nodes across a wall
+// by 1.
+// Above that are levels of ever larger squares, each 2x2 squares of the
+// level below, up to max_square_size cells on a side. The nodes with a wall
+// out of a square are linked by their shortest distance within it, found
+// from the level below. All of this is found once, when constructed.
+// A query links its endpoints to the nodes of their clusters, then searches
+// each part of the graph at the highest level whose square holds neither
+// endpoint, so far off parts are crossed a whole square at a time. The route
+// is filled in level by level, down to the cells within each cluster. Routes
+// through squares & clusters are cached, so later queries along the same
+// ways don't search them again. As every way out of a cluster or square is a
+// node, paths are as short as Pathfinder's.
+// Queries still grow with the area of the grid: the search covers about as
+// much of it as Pathfinder's A* does, only in fewer, longer steps. See
+// mazegen_bench's region_* phases for timings.
+// The walls are read when constructed, so later changes to the grid aren't
+// seen. Not thread safe: use one Region_pathfinder per thread
+class Region_pathfinder final
+{
+public:
+    static const std::uint32_t unreachable = 0xFFFFFFFF;
+
+    // cluster_size is from 2 to 256. num_threads workers build the abstract
+    // graph, a row of sectors at a time (0 for hardware concurrency). grid
+    // must still have its regions (see Grid::drop_regions)
+    explicit Region_pathfinder(const Grid & grid, const unsigned int cluster_size = 32,
+        const unsigned int num_threads = 0);
+
+    // find a shortest path from start to goal. On success, path holds every
+    // cell along it, start & goal included. Returns false, with an empty path,
+    // if goal can't be reached. Throws std::out_of_range if either cell is off
+    // the grid
+    bool find_path(const sf::Vector2u & start, const sf::Vector2u & goal,
+        std::vector<sf::Vector2u> & path);
+
+    // length of a shortest path from start to goal, or unreachable. Only
+    // searches the abstract graph, without filling in the cells
+    std::uint32_t distance(const sf::Vector2u & start, const sf::Vector2u & goal);
+
+    // size of the abstract graph, over all levels
+    std::size_t num_nodes() const;
+    std::size_t num_edges() const;
+    // 1 for clusters alone, plus 1 for each level of squares
+    unsigned int num_levels() const;
+    // abstract nodes taken off the open list by the last query
+    std::size_t num_expanded() const;
+
+    unsigned int width() const;
+    unsigned int height() const;
+
+private:
+    typedef std::uint32_t Cell;
+    typedef std::uint32_t Node;
+    static const Node no_node = 0xFFFFFFFF;
+    static const std::uint8_t no_dir = 0xFF;
+    // a square at each level is (1 << level_bits) squares of the one below on
+    // a side. Level 1 squares are sectors
+    static const unsigned int level_bits = 1;
+    // largest side of a square, in cells. Each node of a square is linked to
+    // most others, so building a level costs about its area times the side
+    static const unsigned int max_square_size = 256;
+    // cached route entries (cells or nodes) kept before the cache is emptied
+    static const std::size_t route_cache_limit = 1 << 22;
+
+    // the cell is copied here so the estimate doesn't need another lookup
+    struct Edge
+    {
+        Node to;
+        Cell cell;
+        std::uint32_t cost;
+    };
+
+    // per-query state. g & parent are only valid while stamp is the query's
+    // generation (on the open list) or generation + 1 (closed)
+    struct Search_node
+    {
+        std::uint32_t stamp;
+        std::uint32_t g;
+        Node parent;
+    };
+
+    struct Open_entry
+    {
+        std::uint32_t f; // cost so far + estimate to goal
+        std::uint32_t h; // estimate to goal, to break ties toward the goal
+        Node node;
+    };
+
+    // edges of one node at one level of squares, in _clique_edges
+    struct Clique_range
+    {
+        std::size_t first;
+        std::uint32_t count;
+    };
+
+    // shortest path search within one square, over the graph of the level
+    // below. Indexed by a node's position among the square's nodes, which
+    // are a run of node numbers for each row of sectors
+    struct Square_search
+    {
+        unsigned int level = 0;
+        unsigned int sector_y = 0; // top row of sectors
+        std::vector<Node> row_first;
+        std::vector<std::uint32_t> row_offset; // position of each row's first node, and the count at the end
+        std::vector<std::uint32_t> stamp;
+        std::vector<std::uint32_t> dist;
+        std::vector<Node> parent;
+        // set if the best path found passes another node of the square's level
+        std::vector<std::uint8_t> via;
+        std::vector<Open_entry> open_list;
+        std::uint32_t generation = 0;
+        // without a target, stops once this many nodes of the square's level are reached
+        std::uint32_t targets_left = 0;
+    };
+
+    // breadth-first search within one cluster. Indexed by a cell's position
+    // within its sector, and invalidated by bumping a generation counter
+    struct Local_search
+    {
+        std::vector<std::uint32_t> stamp;
+        std::vector<std::uint32_t> dist;
+        std::vector<std::uint8_t> back_dir; // toward the root, or no_dir at it
+        std::vector<std::pair<Cell, std::uint32_t>> queue; // cell, local index
+        std::uint32_t generation = 0;
+        Cell origin = 0; // top-left cell of the sector searched
+    };
+
+    void init_local_search(Local_search & search) const;
+    void search_local(Local_search & search, const Cell root, const Cell stop) const;
+    bool reached(const Local_search & search, const Cell cell) const;
+    std::uint32_t local_dist(const Local_search & search, const Cell cell) const;
+
+    void build_sector_row(const unsigned int sector_y, const std::vector<std::uint8_t> & cross_sides,
+        std::vector<Cell> & nodes, std::vector<Node> & sector_counts,
+        std::vector<Edge> & intra_edges, std::vector<std::uint32_t> & intra_counts) const;
+    void build_square_row(const unsigned int level, const unsigned int square_y,
+        std::vector<Edge> & edges, std::vector<std::pair<Node, std::uint32_t>> & counts) const;
+
+    void init_square(Square_search & search, const unsigned int level,
+        const unsigned int square_x, const unsigned int square_y) const;
+    void search_square(Square_search & search, const Node source, const Node target) const;
+    std::uint32_t square_index(const Square_search & search, const Node node) const;
+    template<typename Func>
+    void for_each_edge(const Node node, const unsigned int level, const unsigned int max_cross_level, Func func) const;
+    unsigned int level_apart(const unsigned int sector_diff) const;
+    unsigned int cross_level(const Cell cell, const Direction dir) const;
+    unsigned int search_level(const Node node) const;
+
+    bool search_abstract(const sf::Vector2u & start, const sf::Vector2u & goal);
+    void append_from_root(const Local_search & search, const Cell cell, std::vector<sf::Vector2u> & path) const;
+    void append_edge(const unsigned int level, const Node from, const Node to, std::vector<sf::Vector2u> & path);
+    void relax(const Node node, const Cell cell, const Node parent, const std::uint32_t g);
+    Node pop_open();
+
+    unsigned int sector(const Cell cell) const;
+    std::uint32_t local_index(const Cell cell) const;
+    Node find_node(const Cell cell) const;
+    std::uint32_t estimate(const Cell cell) const;
+    bool open(const Cell cell, const Direction dir) const;
+    Cell step(const Cell cell, const Direction dir) const;
+
+    unsigned int _width, _height;
+    unsigned int _cluster_size;
+    unsigned int _sectors_x, _sectors_y;
+    unsigned int _num_levels = 1;
+
+    // bit (1 << Direction) is set for each side of a cell open to the same
+    // cluster. Walls between clusters are edges of the abstract graph instead
+    std::vector<std::uint8_t> _local_sides;
+
+    // abstract graph. Nodes are ordered by sector, then cell, so a sector's
+    // are [_sector_first[s], _sector_first[s + 1])
+    std::vector<Cell> _node_cell;
+    std::vector<Node> _sector_first;
+    std::vector<std::size_t> _edge_first; // CSR: node n's are [_edge_first[n], _edge_first[n + 1])
+    std::vector<Edge> _edges; // within the cluster, then across each wall in _node_cross, in Direction order
+    std::vector<std::uint8_t> _node_cross; // bit (1 << Direction) for each wall out of the cluster
+    std::vector<std::uint32_t> _cross_levels; // byte n: cross_level of the wall out in Direction n, or 0
+    std::vector<std::uint32_t> _node_sector_y; // saves dividing for it
+    // highest level whose square a wall of the node leads out of. Only nodes
+    // of a level have edges there
+    std::vector<std::uint8_t> _node_level;
+
+    // edges of the higher levels. Node n's at level l are
+    // _clique_ranges[_clique_base[n] + l - 2], in _clique_edges[l - 2]
+    std::vector<std::uint32_t> _clique_base;
+    std::vector<Clique_range> _clique_ranges;
+    std::vector<std::vector<Edge>> _clique_edges;
+
+    // per-query state, as for Pathfinder, but kept together as each node is
+    // likely a cache miss. The endpoints are extra nodes past the end of
+    // _node_cell
+    Node _start_node = 0, _goal_node = 0;
+    Cell _goal = 0;
+    std::vector<Search_node> _search_nodes;
+    std::uint32_t _generation = 0;
+    std::vector<Open_entry> _open_list; // binary min-heap
+    std::size_t _num_expanded = 0;
+    std::vector<Node> _route;
+    unsigned int _start_sector_x = 0, _start_sector_y = 0;
+    unsigned int _goal_sector_x = 0, _goal_sector_y = 0;
+
+    Local_search _start_search, _goal_search;
+    Square_search _route_search;
+
+    // routes filled in, by level - 1 then (from << 32 | to). Cells within a
+    // cluster at level 1, nodes of the level below above that
+    std::vector<std::unordered_map<std::uint64_t, std::vector<std::uint32_t>>> _route_cache;
+    std::size_t _route_cache_size = 0;
+};
+
+inline std::size_t Region_pathfinder::num_nodes() const
+{
+    return _node_cell.size();
+}
+
+inline std::size_t Region_pathfinder::num_edges() const
+{
+    std::size_t count = _edges.size();
+    for(const auto & edges: _clique_edges)
+        count += edges.size();
+    return count;
+}
+
+inline unsigned int Region_pathfinder::num_levels() const
+{
+    return _num_levels;
+}
+
+inline std::size_t Region_pathfinder::num_expanded() const
+{
+    return _num_expanded;
+}
+
+inline unsigned int Region_pathfinder::width() const
+{
+    return _width;
+}
+
+inline unsigned int Region_pathfinder::height() const
+{
+    return _height;
+}
+
+#endif // REGION_PATHFIND_HPP
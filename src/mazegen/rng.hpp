@@ -0,0 +1,159 @@
+// rng.hpp
+// random number engines for maze generation
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef RNG_HPP
+#define RNG_HPP
+
+#include <cstdint>
+
+// SplitMix64. Used to expand seeds into engine state
+inline std::uint64_t splitmix64(std::uint64_t & state)
+{
+    std::uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+// seed for an independent stream, derived from a parent seed and a stream
+// number (tile index, etc)
+inline std::uint64_t substream_seed(const std::uint64_t seed, const std::uint64_t stream)
+{
+    std::uint64_t state = seed;
+    std::uint64_t mixed = splitmix64(state) ^ stream;
+    return splitmix64(mixed);
+}
+
+// xoshiro256** 1.0, by David Blackman and Sebastiano Vigna. Fast, small state,
+// and satisfies UniformRandomBitGenerator, so it works with <random>
+class Xoshiro256ss final
+{
+public:
+    typedef std::uint64_t result_type;
+
+    static constexpr result_type min()
+    {
+        return 0;
+    }
+    static constexpr result_type max()
+    {
+        return ~(result_type)0;
+    }
+
+    explicit Xoshiro256ss(const std::uint64_t seed = 0)
+    {
+        this->seed(seed);
+    }
+
+    void seed(std::uint64_t seed)
+    {
+        for(int i = 0; i < 4; ++i)
+            _s[i] = splitmix64(seed);
+    }
+
+    result_type operator()()
+    {
+        const std::uint64_t result = rotl(_s[1] * 5, 7) * 9;
+        const std::uint64_t t = _s[1] << 17;
+
+        _s[2] ^= _s[0];
+        _s[3] ^= _s[1];
+        _s[1] ^= _s[2];
+        _s[0] ^= _s[3];
+
+        _s[2] ^= t;
+        _s[3] = rotl(_s[3], 45);
+
+        return result;
+    }
+
+private:
+    static std::uint64_t rotl(const std::uint64_t x, const int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    std::uint64_t _s[4];
+};
+
+// engine used by all maze generators. Any UniformRandomBitGenerator that can
+// be constructed from a 64-bit seed may be swapped in here
+typedef Xoshiro256ss Mazegen_rng;
+
+// random permutation of [0, size), computed for each index rather than
+// stored. A 4 round Feistel network over the smallest even number of bits
+// covering size, cycle-walking past values out of range. Less uniform than a
+// shuffle, but uses no memory
+class Index_permutation final
+{
+public:
+    Index_permutation(const std::uint64_t size, Mazegen_rng & prng):
+        _size(size)
+    {
+        unsigned int bits = 2;
+        while(bits < 64 && ((std::uint64_t)1 << bits) < size)
+            bits += 2;
+        _half_bits = bits / 2;
+        _half_mask = ((std::uint64_t)1 << _half_bits) - 1;
+
+        for(auto & key: _keys)
+            key = prng();
+    }
+
+    std::uint64_t size() const
+    {
+        return _size;
+    }
+
+    // the index at position i, for i in [0, size)
+    std::uint64_t operator()(std::uint64_t i) const
+    {
+        // the network's domain is at most 4 times size, so this takes a few
+        // rounds at most, on average
+        do
+            i = encrypt(i);
+        while(i >= _size);
+        return i;
+    }
+
+private:
+    std::uint64_t encrypt(const std::uint64_t i) const
+    {
+        std::uint64_t left = i >> _half_bits, right = i & _half_mask;
+        for(const auto key: _keys)
+        {
+            std::uint64_t mixed = right ^ key;
+            std::uint64_t next_right = left ^ (splitmix64(mixed) & _half_mask);
+            left = right;
+            right = next_right;
+        }
+        return (left << _half_bits) | right;
+    }
+
+    std::uint64_t _size;
+    unsigned int _half_bits;
+    std::uint64_t _half_mask;
+    std::uint64_t _keys[4];
+};
+
+#endif // RNG_HPP
@@ -0,0 +1,115 @@
+// mesh_builder.cpp
+// interleaved, indexed vertex buffers
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "opengl/mesh_builder.hpp"
+
+#include <cstddef>
+
+void Mesh_builder::reserve(const std::size_t num_verts, const std::size_t num_indexes)
+{
+    _verts.reserve(_verts.size() + num_verts);
+    _indexes.reserve(_indexes.size() + num_indexes);
+}
+
+void Mesh_builder::clear()
+{
+    _verts.clear();
+    _indexes.clear();
+}
+
+void Mesh_builder::resize(const std::size_t num_verts, const std::size_t num_indexes)
+{
+    _verts.resize(num_verts);
+    _indexes.resize(num_indexes);
+}
+
+void Mesh_builder::add_quad(const Vertex & v0, const Vertex & v1, const Vertex & v2, const Vertex & v3)
+{
+    GLuint first = _verts.size();
+    _verts.insert(_verts.end(), {v0, v1, v2, v3});
+    _indexes.insert(_indexes.end(), {first, first + 1, first + 2, first + 2, first + 1, first + 3});
+}
+
+void Mesh_builder::set_quad(const std::size_t vert, const std::size_t index,
+    const Vertex & v0, const Vertex & v1, const Vertex & v2, const Vertex & v3)
+{
+    GLuint first = vert;
+    _verts[vert] = v0;
+    _verts[vert + 1] = v1;
+    _verts[vert + 2] = v2;
+    _verts[vert + 3] = v3;
+
+    GLuint * indexes = &_indexes[index];
+    indexes[0] = first;
+    indexes[1] = first + 1;
+    indexes[2] = first + 2;
+    indexes[3] = first + 2;
+    indexes[4] = first + 1;
+    indexes[5] = first + 3;
+}
+
+void Mesh_builder::upload(const GL_vertex_array & vao, const GL_buffer & vbo, const GL_buffer & ebo,
+    GLsizeiptr & vbo_capacity, GLsizeiptr & ebo_capacity) const
+{
+    GLsizeiptr verts_size = sizeof(Vertex) * _verts.size();
+    GLsizeiptr indexes_size = sizeof(GLuint) * _indexes.size();
+
+    vao.bind();
+
+    // reuse the buffers' storage when it's big enough
+    vbo.bind();
+    if(verts_size > vbo_capacity)
+    {
+        glBufferData(vbo.type(), verts_size, _verts.data(), GL_STATIC_DRAW);
+        vbo_capacity = verts_size;
+    }
+    else
+        glBufferSubData(vbo.type(), 0, verts_size, _verts.data());
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid *)offsetof(Vertex, pos));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid *)offsetof(Vertex, tex_coord));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid *)offsetof(Vertex, normal));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid *)offsetof(Vertex, tangent));
+    glEnableVertexAttribArray(3);
+
+    // the element array binding is part of the vao's state
+    ebo.bind();
+    if(indexes_size > ebo_capacity)
+    {
+        glBufferData(ebo.type(), indexes_size, _indexes.data(), GL_STATIC_DRAW);
+        ebo_capacity = indexes_size;
+    }
+    else
+        glBufferSubData(ebo.type(), 0, indexes_size, _indexes.data());
+
+    glBindVertexArray(0);
+}
+
+void Mesh_builder::upload(const GL_vertex_array & vao, const GL_buffer & vbo, const GL_buffer & ebo) const
+{
+    GLsizeiptr vbo_capacity = 0, ebo_capacity = 0;
+    upload(vao, vbo, ebo, vbo_capacity, ebo_capacity);
+}
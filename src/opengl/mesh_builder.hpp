@@ -0,0 +1,105 @@
+// mesh_builder.hpp
+// interleaved, indexed vertex buffers
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MESH_BUILDER_HPP
+#define MESH_BUILDER_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "opengl/gl_wrappers.hpp"
+
+// a vertex in the layout all models use: attribute 0 is pos, 1 tex_coord,
+// 2 normal, and 3 tangent
+struct Vertex
+{
+    glm::vec3 pos;
+    glm::vec2 tex_coord;
+    glm::vec3 normal;
+    glm::vec3 tangent;
+};
+
+// Builds vertices & 32-bit indexes on the CPU, for upload as one interleaved
+// vertex buffer & one index buffer. Drawn with glDrawElements, so vertices
+// shared by triangles are transformed once, and each vertex's attributes are
+// read from the same cache lines
+class Mesh_builder final
+{
+public:
+    // reserve room for more vertices & indexes, beyond those already added
+    void reserve(const std::size_t num_verts, const std::size_t num_indexes);
+    void clear();
+    // set the number of vertices & indexes. New ones are left for set_quad
+    void resize(const std::size_t num_verts, const std::size_t num_indexes);
+
+    // returns the new vertex's index
+    GLuint add_vert(const Vertex & vert);
+    void add_index(const GLuint index);
+    // 2 triangles: v0, v1, v2 and v2, v1, v3
+    void add_quad(const Vertex & v0, const Vertex & v1, const Vertex & v2, const Vertex & v3);
+    // write a quad as add_quad would, with its vertices from vert & its
+    // indexes from index. Threads may fill separate ranges of a resized
+    // builder at once
+    void set_quad(const std::size_t vert, const std::size_t index,
+        const Vertex & v0, const Vertex & v1, const Vertex & v2, const Vertex & v3);
+
+    std::size_t num_verts() const;
+    std::size_t num_indexes() const;
+
+    // upload to vbo & ebo, and point vao's attributes at vbo. Each buffer's
+    // storage is reused if it fits in its capacity (bytes), and capacity is
+    // updated otherwise
+    void upload(const GL_vertex_array & vao, const GL_buffer & vbo, const GL_buffer & ebo,
+        GLsizeiptr & vbo_capacity, GLsizeiptr & ebo_capacity) const;
+    // upload into new buffers
+    void upload(const GL_vertex_array & vao, const GL_buffer & vbo, const GL_buffer & ebo) const;
+
+private:
+    std::vector<Vertex> _verts;
+    std::vector<GLuint> _indexes;
+};
+
+inline GLuint Mesh_builder::add_vert(const Vertex & vert)
+{
+    _verts.push_back(vert);
+    return _verts.size() - 1;
+}
+
+inline void Mesh_builder::add_index(const GLuint index)
+{
+    _indexes.push_back(index);
+}
+
+inline std::size_t Mesh_builder::num_verts() const
+{
+    return _verts.size();
+}
+
+inline std::size_t Mesh_builder::num_indexes() const
+{
+    return _indexes.size();
+}
+
+#endif // MESH_BUILDER_HPP
@@ -0,0 +1,55 @@
+// frustum.cpp
+// view frustum planes, for culling
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "util/frustum.hpp"
+
+// Gribb & Hartmann: each plane is the last row of the matrix plus or minus
+// one of the others. glm is column-major, so row i is m[0..3][i]
+Frustum::Frustum(const glm::mat4 & view_proj)
+{
+    glm::vec4 rows[4];
+    for(int i = 0; i < 4; ++i)
+        rows[i] = glm::vec4(view_proj[0][i], view_proj[1][i], view_proj[2][i], view_proj[3][i]);
+
+    for(int i = 0; i < 3; ++i)
+    {
+        _planes[2 * i] = rows[3] + rows[i];
+        _planes[2 * i + 1] = rows[3] - rows[i];
+    }
+}
+
+// test the corner furthest along each plane's normal
+bool Frustum::intersects(const glm::vec3 & min, const glm::vec3 & max) const
+{
+    for(const auto & plane: _planes)
+    {
+        glm::vec3 corner(plane.x >= 0.0f ? max.x : min.x,
+            plane.y >= 0.0f ? max.y : min.y,
+            plane.z >= 0.0f ? max.z : min.z);
+
+        if(plane.x * corner.x + plane.y * corner.y + plane.z * corner.z + plane.w < 0.0f)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,49 @@
+// frustum.hpp
+// view frustum planes, for culling
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef FRUSTUM_HPP
+#define FRUSTUM_HPP
+
+#include <glm/glm.hpp>
+
+// the 6 planes of a view volume, extracted from a projection matrix. Given a
+// model-view-projection matrix, the planes are in model space, so a model can
+// test its own bounds without transforming them. Works for perspective &
+// orthographic projections
+class Frustum final
+{
+public:
+    explicit Frustum(const glm::mat4 & view_proj);
+
+    // false only if the box [min, max] is entirely outside. Boxes near a
+    // corner of the frustum may pass without being inside, which is safe
+    bool intersects(const glm::vec3 & min, const glm::vec3 & max) const;
+
+private:
+    // ax + by + cz + d >= 0 inside each plane. Not normalized, as only the
+    // sign is used
+    glm::vec4 _planes[6];
+};
+
+#endif // FRUSTUM_HPP
@@ -0,0 +1,212 @@
+// parallel.hpp
+// simple data-parallel helpers
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// number of worker threads to use when 0 is requested
+inline unsigned int default_num_threads()
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// fixed set of worker threads shared by every parallel_for, started on first
+// use and kept until the program exits. A thread that hands out a job also
+// works on it, so there's one worker fewer than default_num_threads, and a
+// job started from inside another can't deadlock waiting for free workers
+class Thread_pool final
+{
+public:
+    static Thread_pool & get();
+    ~Thread_pool();
+
+    unsigned int size() const;
+
+    // run job on the calling thread & up to num_helpers workers at once, and
+    // return once every call has returned. job is called concurrently, and
+    // each call should take work until there's none left
+    void run(const std::function<void()> & job, const unsigned int num_helpers);
+
+private:
+    struct Job
+    {
+        const std::function<void()> * func;
+        unsigned int unclaimed; // helpers wanted, but not started yet
+        unsigned int running; // helpers not finished yet
+        std::condition_variable done;
+    };
+
+    explicit Thread_pool(const unsigned int size);
+
+    void worker();
+
+    std::mutex _lock;
+    std::condition_variable _cv;
+    std::deque<Job *> _jobs;
+    bool _quit = false;
+
+    std::vector<std::thread> _threads;
+};
+
+inline Thread_pool & Thread_pool::get()
+{
+    static Thread_pool pool(default_num_threads() - 1);
+    return pool;
+}
+
+inline Thread_pool::Thread_pool(const unsigned int size)
+{
+    for(unsigned int i = 0; i < size; ++i)
+        _threads.emplace_back(&Thread_pool::worker, this);
+}
+
+inline Thread_pool::~Thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _quit = true;
+    }
+    _cv.notify_all();
+
+    for(auto & thread: _threads)
+        thread.join();
+}
+
+inline unsigned int Thread_pool::size() const
+{
+    return _threads.size();
+}
+
+inline void Thread_pool::run(const std::function<void()> & job, const unsigned int num_helpers)
+{
+    unsigned int helpers = std::min(num_helpers, size());
+
+    Job shared;
+    shared.func = &job;
+    shared.unclaimed = helpers;
+    shared.running = 0;
+
+    if(helpers > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+            _jobs.push_back(&shared);
+        }
+        if(helpers == 1)
+            _cv.notify_one();
+        else
+            _cv.notify_all();
+    }
+
+    job();
+
+    // by now there's no work left, so helpers that haven't started aren't
+    // needed. Wait for those that have, as shared lives on this stack
+    std::unique_lock<std::mutex> lock(_lock);
+    if(shared.unclaimed > 0)
+    {
+        _jobs.erase(std::find(_jobs.begin(), _jobs.end(), &shared));
+        shared.unclaimed = 0;
+    }
+    shared.done.wait(lock, [&shared](){ return shared.running == 0; });
+}
+
+inline void Thread_pool::worker()
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    while(true)
+    {
+        _cv.wait(lock, [this](){ return _quit || !_jobs.empty(); });
+        if(_quit)
+            return;
+
+        Job * job = _jobs.front();
+        if(--job->unclaimed == 0)
+            _jobs.pop_front();
+        ++job->running;
+
+        lock.unlock();
+        (*job->func)();
+        lock.lock();
+
+        if(--job->running == 0)
+            job->done.notify_one();
+    }
+}
+
+// call func(i) for each i in [0, count), spread across the calling thread
+// and up to num_threads - 1 of Thread_pool's workers (0 for all of them),
+// which pull indexes in order. The first exception thrown by func is
+// rethrown here
+template<typename F>
+void parallel_for(const std::size_t count, const F & func, unsigned int num_threads = 0)
+{
+    if(count == 0)
+        return;
+
+    if(num_threads == 0)
+        num_threads = default_num_threads();
+    num_threads = (unsigned int)std::min<std::size_t>(num_threads, count);
+
+    std::atomic<std::size_t> next(0);
+    std::exception_ptr error;
+    std::mutex error_lock;
+
+    std::function<void()> worker = [&]()
+    {
+        for(std::size_t i = next++; i < count; i = next++)
+        {
+            try
+            {
+                func(i);
+            }
+            catch(...)
+            {
+                std::lock_guard<std::mutex> lock(error_lock);
+                if(!error)
+                    error = std::current_exception();
+                next = count;
+            }
+        }
+    };
+
+    if(num_threads <= 1)
+        worker();
+    else
+        Thread_pool::get().run(worker, num_threads - 1);
+
+    if(error)
+        std::rethrow_exception(error);
+}
+
+#endif // PARALLEL_HPP
@@ -40,6 +40,7 @@
 #include "opengl/gl_helpers.hpp"
 #endif
 
+#include "util/frustum.hpp"
 #include "util/logger.hpp"
 
 void World::draw()
@@ -91,7 +92,7 @@ void World::draw()
             glUniformMatrix4fv(_ent_prepass_prog.get_uniform("model_view_proj"), 1, GL_FALSE, &model_view_proj[0][0]);
             glUniformMatrix3fv(_ent_prepass_prog.get_uniform("normal_transform"), 1, GL_FALSE, &normal_transform[0][0]);
 
-            model->draw(set_prepass_material);
+            model->draw_visible(set_prepass_material, Frustum(model_view_proj));
 
             #ifdef DEBUG
             check_error("World::draw - prepass");
@@ -207,7 +208,7 @@ void World::draw()
                     glUniformMatrix4fv(_point_shadow_prog.get_uniform("model"), 1, GL_FALSE, &model_mat[0][0]);
                     glUniform3fv(_point_shadow_prog.get_uniform("light_world_pos"), 1, &light_world_pos[0]);
 
-                    model->draw([](const Material &){});
+                    model->draw_visible([](const Material &){}, Frustum(model_view_proj));
 
                     #ifdef DEBUG
                     check_error("World::draw - spot light shadow map");
@@ -314,7 +315,7 @@ void World::draw()
                 glm::mat4 model_view_proj = view_proj * ent_2->model_mat();
                 glUniformMatrix4fv(_spot_dir_shadow_prog.get_uniform("model_view_proj"), 1, GL_FALSE, &model_view_proj[0][0]);
 
-                model->draw([](const Material &){});
+                model->draw_visible([](const Material &){}, Frustum(model_view_proj));
 
                 #ifdef DEBUG
                 check_error("World::draw - spot light shadow map");
@@ -399,7 +400,7 @@ void World::draw()
                 glm::mat4 model_view_proj = view_proj * ent->model_mat();
                 glUniformMatrix4fv(_spot_dir_shadow_prog.get_uniform("model_view_proj"), 1, GL_FALSE, &model_view_proj[0][0]);
 
-                model->draw([](const Material &){});
+                model->draw_visible([](const Material &){}, Frustum(model_view_proj));
 
                 #ifdef DEBUG
                 check_error("World::draw - dir light shadow map");
@@ -482,7 +483,7 @@ void World::draw()
         glUniformMatrix4fv(_ent_prog.get_uniform("model_view"), 1, GL_FALSE, &model_view[0][0]);
         glUniformMatrix4fv(_ent_prog.get_uniform("model_view_proj"), 1, GL_FALSE, &model_view_proj[0][0]);
 
-        model->draw(set_material);
+        model->draw_visible(set_material, Frustum(model_view_proj));
 
     }
 
@@ -0,0 +1,207 @@
+// path_service.cpp
+// pathfinding on worker threads, with results sent as messages
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "world/path_service.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+#include "util/logger.hpp"
+#include "util/message.hpp"
+#include "util/parallel.hpp"
+
+Path_service::Path_service(const Grid & grid, const std::string & event,
+    const unsigned int num_workers):
+    _event(event), _width(grid.width()), _height(grid.height())
+{
+    unsigned int count = num_workers == 0 ? default_num_threads() : num_workers;
+
+    // copy the walls before starting any threads
+    for(unsigned int i = 0; i < count; ++i)
+        _pathfinders.emplace_back(new Pathfinder(grid));
+
+    for(unsigned int i = 0; i < count; ++i)
+        _workers.emplace_back(&Path_service::worker, this, i);
+
+    Logger_locator::get()(Logger::DBG, "Path service started with " + std::to_string(count) + " workers");
+}
+
+Path_service::~Path_service()
+{
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _quit = true;
+    }
+    _cv.notify_all();
+
+    for(auto & worker: _workers)
+        worker.join();
+}
+
+Path_service::Request_id Path_service::request(const sf::Vector2u & start, const sf::Vector2u & goal)
+{
+    if(start.x >= _width || start.y >= _height || goal.x >= _width || goal.y >= _height)
+    {
+        throw std::out_of_range("path endpoint off grid: (" +
+            std::to_string(start.x) + ", " + std::to_string(start.y) + ") to (" +
+            std::to_string(goal.x) + ", " + std::to_string(goal.y) + ")");
+    }
+
+    std::unique_lock<std::mutex> lock(_lock);
+
+    Request_id id = _next_id++;
+    ++_stats.requests;
+
+    auto & search = _unfinished[key(start, goal)];
+    bool coalesced = (bool)search;
+    if(coalesced)
+        ++_stats.coalesced;
+    else
+    {
+        search = std::make_shared<Search>();
+        search->start = start;
+        search->goal = goal;
+        _queue.push_back(search);
+    }
+
+    search->requests.emplace_back(id, Clock::now());
+    _search_of[id] = search;
+
+    lock.unlock();
+    if(!coalesced)
+        _cv.notify_one();
+
+    return id;
+}
+
+void Path_service::cancel(const Request_id id)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+
+    auto search_it = _search_of.find(id);
+    if(search_it != _search_of.end())
+    {
+        auto search = search_it->second;
+        _search_of.erase(search_it);
+        ++_stats.cancelled;
+
+        search->requests.erase(std::find_if(search->requests.begin(), search->requests.end(),
+            [id](const std::pair<Request_id, Clock::time_point> & request){ return request.first == id; }));
+
+        // queued searches are skipped by the workers. Running ones finish,
+        // but their results are dropped. Either way, a new request for the
+        // same path starts over
+        if(search->requests.empty())
+        {
+            search->cancelled = true;
+            _unfinished.erase(key(search->start, search->goal));
+        }
+        return;
+    }
+
+    auto ready_it = std::find_if(_ready.begin(), _ready.end(),
+        [id](const Path_result & result){ return result.id == id; });
+    if(ready_it != _ready.end())
+    {
+        _ready.erase(ready_it);
+        ++_stats.cancelled;
+    }
+}
+
+void Path_service::post_results(const std::size_t max_results)
+{
+    std::vector<Path_result> results;
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        std::size_t count = std::min(max_results, _ready.size());
+        std::move(_ready.begin(), _ready.begin() + count, std::back_inserter(results));
+        _ready.erase(_ready.begin(), _ready.begin() + count);
+    }
+
+    for(auto & result: results)
+        Message_locator::get().queue_event(_event, std::move(result));
+}
+
+Path_service::Stats Path_service::stats()
+{
+    std::lock_guard<std::mutex> lock(_lock);
+
+    Stats stats = _stats;
+    stats.queue_depth = std::count_if(_queue.begin(), _queue.end(),
+        [](const std::shared_ptr<Search> & search){ return !search->cancelled; });
+    stats.ready = _ready.size();
+    stats.mean_latency_s = stats.completed ? _total_latency_s / stats.completed : 0.0;
+    return stats;
+}
+
+// Pathfinder limits grids to 2^32 cells, so both cells fit
+std::uint64_t Path_service::key(const sf::Vector2u & start, const sf::Vector2u & goal) const
+{
+    return ((std::uint64_t)(start.y * _width + start.x) << 32) | (goal.y * _width + goal.x);
+}
+
+void Path_service::worker(const unsigned int worker_id)
+{
+    Pathfinder & pathfinder = *_pathfinders[worker_id];
+
+    while(true)
+    {
+        std::shared_ptr<Search> search;
+        {
+            std::unique_lock<std::mutex> lock(_lock);
+            _cv.wait(lock, [this](){ return _quit || !_queue.empty(); });
+            if(_quit)
+                return;
+
+            search = _queue.front();
+            _queue.pop_front();
+            if(search->cancelled)
+                continue;
+
+            ++_stats.in_progress;
+        }
+
+        auto path = std::make_shared<std::vector<sf::Vector2u>>();
+        bool found = pathfinder.find_path(search->start, search->goal, *path);
+
+        std::lock_guard<std::mutex> lock(_lock);
+        --_stats.in_progress;
+        if(search->cancelled)
+            continue;
+
+        _unfinished.erase(key(search->start, search->goal));
+
+        Clock::time_point now = Clock::now();
+        for(const auto & request: search->requests)
+        {
+            _search_of.erase(request.first);
+            _ready.push_back({request.first, search->start, search->goal, found, path});
+
+            double latency_s = std::chrono::duration<double>(now - request.second).count();
+            _total_latency_s += latency_s;
+            _stats.max_latency_s = std::max(_stats.max_latency_s, latency_s);
+            ++_stats.completed;
+        }
+    }
+}
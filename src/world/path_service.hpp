@@ -0,0 +1,135 @@
+// path_service.hpp
+// pathfinding on worker threads, with results sent as messages
+
+// Copyright 2015 Matthew Chandler
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef PATH_SERVICE_HPP
+#define PATH_SERVICE_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <SFML/System.hpp>
+
+#include "mazegen/grid.hpp"
+#include "mazegen/pathfind.hpp"
+
+// packet for path results. Retrieve with
+// Message::get_packet<Path_result>(pkt)
+struct Path_result
+{
+    std::uint64_t id; // as returned by Path_service::request
+    sf::Vector2u start, goal;
+    bool found;
+    // every cell from start to goal, or empty if not found. Shared by all
+    // requests for the same start & goal that were served together
+    std::shared_ptr<const std::vector<sf::Vector2u>> path;
+};
+
+// finds paths on worker threads, so the main loop never waits on a search.
+// Results are held until post_results, which queues up to a given number of
+// them as events on Message_locator's Message. Requests with the same start &
+// goal as one not finished yet share its search. Each worker copies the grid's
+// walls when constructed, so later changes to the grid aren't seen
+class Path_service final
+{
+public:
+    typedef std::uint64_t Request_id;
+
+    // for sizing the worker pool. Counts are since construction. Latency is
+    // from request until the result is ready to post
+    struct Stats
+    {
+        std::size_t queue_depth; // searches waiting for a worker
+        std::size_t in_progress; // searches running
+        std::size_t ready; // results waiting for post_results
+        std::uint64_t requests;
+        std::uint64_t coalesced; // requests that shared an earlier search
+        std::uint64_t cancelled;
+        std::uint64_t completed; // results made ready
+        double mean_latency_s;
+        double max_latency_s;
+    };
+
+    // num_workers threads, each with its own Pathfinder (0 for hardware
+    // concurrency). Results are sent as event
+    explicit Path_service(const Grid & grid, const std::string & event = "path_found",
+        const unsigned int num_workers = 1);
+    ~Path_service();
+
+    // queue a search. Throws std::out_of_range if either cell is off the grid
+    Request_id request(const sf::Vector2u & start, const sf::Vector2u & goal);
+    // drop a request, whether or not its result is ready. The search itself is
+    // dropped too, unless it's running, or shared with other requests
+    void cancel(const Request_id id);
+
+    // queue at most max_results ready results as messages, oldest first.
+    // Call once per frame, so a burst of results is spread over several
+    void post_results(const std::size_t max_results);
+
+    Stats stats();
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Search
+    {
+        sf::Vector2u start, goal;
+        // requests waiting on this search, and when each was made
+        std::vector<std::pair<Request_id, Clock::time_point>> requests;
+        bool cancelled = false;
+    };
+
+    std::uint64_t key(const sf::Vector2u & start, const sf::Vector2u & goal) const;
+
+    void worker(const unsigned int worker_id);
+
+    std::string _event;
+    unsigned int _width, _height;
+
+    // one per worker, only used by that worker
+    std::vector<std::unique_ptr<Pathfinder>> _pathfinders;
+
+    // shared with the workers, guarded by _lock
+    std::mutex _lock;
+    std::condition_variable _cv;
+    std::deque<std::shared_ptr<Search>> _queue;
+    // searches not finished yet, by start & goal
+    std::unordered_map<std::uint64_t, std::shared_ptr<Search>> _unfinished;
+    std::unordered_map<Request_id, std::shared_ptr<Search>> _search_of;
+    std::deque<Path_result> _ready;
+    Request_id _next_id = 0;
+    Stats _stats = {};
+    double _total_latency_s = 0.0;
+    bool _quit = false;
+
+    std::vector<std::thread> _workers;
+};
+
+#endif // PATH_SERVICE_HPP
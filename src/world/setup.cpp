@@ -23,12 +23,19 @@
 
 #include "world/world.hpp"
 
+#include <fstream>
+#include <random>
+
+#include "config.hpp"
 #include "entities/player.hpp"
 #include "entities/testmdl.hpp"
+#include "mazegen/maze_file.hpp"
 #include "opengl/gl_helpers.hpp"
 #include "util/logger.hpp"
 
-World::World():
+extern thread_local std::random_device rng; // defined in world.cpp
+
+World::World(const bool endless_maze):
     _win(sf::VideoMode(800, 600), "mazerun", sf::Style::Default, sf::ContextSettings(0, 0, 0)),
     _running(true), _focused(true), _do_resize(false), _use_fxaa(true),
     _sunlight(true, glm::vec3(1.0f, 1.0f, 1.0f), true, glm::normalize(glm::vec3(-1.0f))),
@@ -104,8 +111,29 @@ World::World():
     _ents.emplace_back(create_testlight());
     _ents.emplace_back(create_testmonkey());
     _ents.emplace_back(create_testdoughnut());
-    _ents.emplace_back(create_walls(32, 32));
-    _ents.emplace_back(create_floor(32, 32));
+
+    // endless maze, or a pregenerated one if there is one, otherwise make a new one
+    std::string maze_filename = check_in_pwd("maze.mzg");
+    if(endless_maze)
+    {
+        _ents.emplace_back(create_maze_chunks(rng()));
+        _maze_chunks = dynamic_cast<Maze_chunks *>(_ents.back().model());
+    }
+    else if(std::ifstream(maze_filename.c_str()))
+    {
+        Maze_file maze_file(maze_filename);
+        Maze_file_row_reader maze_rows(maze_file);
+        _ents.emplace_back(create_walls(maze_rows));
+        _ents.emplace_back(create_floor(maze_file.width(), maze_file.height()));
+    }
+    else
+    {
+        _ents.emplace_back(create_walls(32, 32, rng()));
+        const Grid * grid = dynamic_cast<Walls *>(_ents.back().model())->grid();
+        if(grid)
+            _path_service.reset(new Path_service(*grid));
+        _ents.emplace_back(create_floor(32, 32));
+    }
 
     _cam = _player = &_ents[0];
 
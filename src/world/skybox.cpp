@@ -28,6 +28,7 @@
 
 #include "config.hpp"
 #include "opengl/gl_helpers.hpp"
+#include "opengl/mesh_builder.hpp"
 #include "util/logger.hpp"
 
 // TODO: replace bottom half of skybox with ground (if doing environment mapping)
@@ -43,7 +44,11 @@ Skybox::Skybox():
 {
     Logger_locator::get()(Logger::DBG, "Creating skybox");
     // TODO: a sphere might look better
-    std::vector<glm::vec3> vert_pos =
+
+    // the shader only reads pos, so the other attributes are left 0
+    Mesh_builder builder;
+    builder.reserve(8, 36);
+    for(const glm::vec3 & pos:
     {
         glm::vec3(-1.0f, -1.0f, -1.0f), // 0
         glm::vec3(1.0f, -1.0f, -1.0f), // 1
@@ -53,9 +58,12 @@ Skybox::Skybox():
         glm::vec3(1.0f, 1.0f, -1.0f), // 5
         glm::vec3(-1.0f, 1.0f, 1.0f), // 6
         glm::vec3(1.0f, 1.0f, 1.0f) // 7
-    };
+    })
+    {
+        builder.add_vert({pos, glm::vec2(0.0f), glm::vec3(0.0f), glm::vec3(0.0f)});
+    }
 
-    std::vector<GLuint> index =
+    for(GLuint index:
     {
         // front
         0, 1, 5,
@@ -75,22 +83,14 @@ Skybox::Skybox():
         // bottom
         2, 3, 1,
         2, 1, 0
-    };
+    })
+    {
+        builder.add_index(index);
+    }
 
     // create OpenGL vertex objects
-    _vao.bind();
-    _vbo.bind();
-
-    glBufferData(_vbo.type(), sizeof(glm::vec3) * vert_pos.size(), vert_pos.data(), GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, NULL);
-    glEnableVertexAttribArray(0);
-
-    _ebo.bind();
-    glBufferData(_ebo.type(), sizeof(GLuint) * index.size(), index.data(), GL_STATIC_DRAW);
-
-    glBindVertexArray(0);
-    _num_indexes = index.size();
+    builder.upload(_vao, _vbo, _ebo);
+    _num_indexes = builder.num_indexes();
 
     _prog.use();
     glUniform1i(_prog.get_uniform("cubemap"), 13);
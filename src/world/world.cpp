@@ -47,7 +47,6 @@
 
 #include "util/logger.hpp"
 
-thread_local std::mt19937 prng;
 thread_local std::random_device rng;
 
 extern std::atomic_bool interrupted; // defined in main.cpp
@@ -113,7 +112,6 @@ void World::game_loop()
 
 void World::event_loop()
 {
-    prng.seed(rng());
     while(true)
     {
         // handle events
@@ -155,7 +153,6 @@ void World::event_loop()
 void World::main_loop()
 {
     sf::Clock dt_clk;
-    prng.seed(rng());
     _win.setActive(true); // set render context active for this thread
     while(true)
     {
@@ -194,6 +191,14 @@ void World::main_loop()
             }
         }
 
+        // stream in maze chunks around the player
+        if(_maze_chunks)
+            _maze_chunks->update(_player->pos());
+
+        // hand finished paths to the message thread, a few at a time
+        if(_path_service)
+            _path_service->post_results(path_results_per_frame);
+
         for(auto & ent: _ents)
         {
             auto audio = ent.audio();
@@ -232,7 +237,6 @@ void World::main_loop()
 
 void World::message_loop()
 {
-    prng.seed(rng());
     while(true)
     {
         if(!_running || interrupted)
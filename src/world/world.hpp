@@ -37,6 +37,7 @@
 #include <sigc++/sigc++.h>
 
 #include "components/light.hpp"
+#include "entities/maze_chunks.hpp"
 #include "entities/walls.hpp"
 #include "opengl/framebuffer.hpp"
 #include "opengl/renderbuffer.hpp"
@@ -45,6 +46,7 @@
 #include "util/message.hpp"
 #include "util/static_text.hpp"
 #include "world/entity.hpp"
+#include "world/path_service.hpp"
 #include "world/quad.hpp"
 #include "world/skybox.hpp"
 
@@ -59,7 +61,8 @@ private:
 class World final // TODO: make this a singleton?
 {
 public:
-    World(); // TODO should we take default args?
+    // endless_maze: stream an endless maze around the player, instead of a fixed one
+    World(const bool endless_maze = false); // TODO should we take more default args?
     void draw();
     void resize();
     void game_loop();
@@ -126,6 +129,14 @@ private:
 
     Entity * _cam;
     Entity * _player;
+
+    // null unless running an endless maze
+    Maze_chunks * _maze_chunks = nullptr;
+
+    // paths on the fixed maze. null when there's no grid to search
+    std::unique_ptr<Path_service> _path_service;
+    // path results sent as messages per frame
+    static const std::size_t path_results_per_frame = 16;
 };
 
 #endif // WORLD_HPP